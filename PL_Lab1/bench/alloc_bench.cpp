@@ -0,0 +1,111 @@
+// Heap allocations made while parsing, per AST node.
+//
+// Usage: alloc_bench <source-file>
+// Parses the file repeated to about 16 MB with the streaming Lexer +
+// Parser and counts every global operator new call, made directly or
+// through the arena's upstream resource, during the parse, and the frees
+// during the teardown of the result.
+
+#include "bench.h"
+#include "../include/parser.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::atomic<size_t> allocations{0};
+std::atomic<size_t> allocatedBytes{0};
+std::atomic<size_t> frees{0};
+
+void* countedAllocate(std::size_t size, std::size_t alignment) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    void* p = nullptr;
+    if (alignment <= alignof(std::max_align_t)) {
+        p = std::malloc(size ? size : 1);
+    } else {
+        // aligned_alloc wants a multiple of the alignment.
+        p = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    }
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void countedFree(void* p) {
+    if (p) frees.fetch_add(1, std::memory_order_relaxed);
+    std::free(p);
+}
+
+constexpr size_t INPUT_SIZE = 16 * 1000 * 1000;
+
+size_t countNodes(const ASTNode* root) {
+    size_t count = 0;
+    std::vector<const ASTNode*> pending;
+    if (root) pending.push_back(root);
+    while (!pending.empty()) {
+        const ASTNode* node = pending.back();
+        pending.pop_back();
+        ++count;
+        for (const ASTNode* child : node->children) pending.push_back(child);
+    }
+    return count;
+}
+
+} // namespace
+
+void* operator new(std::size_t size) { return countedAllocate(size, 0); }
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return countedAllocate(size, static_cast<std::size_t>(alignment));
+}
+void operator delete(void* p) noexcept { countedFree(p); }
+void operator delete(void* p, std::size_t) noexcept { countedFree(p); }
+void operator delete(void* p, std::align_val_t) noexcept { countedFree(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { countedFree(p); }
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::fprintf(stderr, "Usage: %s <source-file>\n", argv[0]);
+        return 2;
+    }
+    try {
+        std::string text = repeatFile(argv[1], INPUT_SIZE);
+
+        size_t parseAllocations = 0;
+        size_t parseBytes = 0;
+        size_t teardownFrees = 0;
+        auto result = std::make_unique<ParseResult>();
+        double parseSeconds = timeOnce([&] {
+            size_t before = allocations;
+            size_t beforeBytes = allocatedBytes;
+            Lexer lexer(text);
+            Parser parser(lexer);
+            *result = parser.parse();
+            parseAllocations = allocations - before;
+            parseBytes = allocatedBytes - beforeBytes;
+        });
+        size_t nodes = countNodes(result->tree);
+        double teardownSeconds = timeOnce([&] {
+            size_t before = frees;
+            result.reset();
+            teardownFrees = frees - before;
+        });
+
+        std::printf("Parse allocations (%.1f MB input, %zu nodes):\n", text.size() / MB, nodes);
+        std::printf("  parse     %9zu allocations %9.2e per node %6.1f bytes per node %7.3f s\n",
+                    parseAllocations, double(parseAllocations) / nodes,
+                    double(parseBytes) / nodes, parseSeconds);
+        std::printf("  teardown  %9zu frees %44s %7.3f s\n", teardownFrees, "", teardownSeconds);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,62 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "../include/source_buffer.h"
+#include <chrono>
+#include <ctime>
+#include <string>
+
+// Helpers shared by the programs `make bench` runs. Timings are the best
+// of several runs, which is the least noisy figure on a shared machine.
+
+// The file at path repeated until the text is at least size bytes.
+inline std::string repeatFile(const std::string& path, size_t size) {
+    SourceBuffer file = SourceBuffer::fromFile(path);
+    std::string text;
+    text.reserve(size + file.size());
+    while (text.size() < size) text.append(file.view());
+    return text;
+}
+
+// Seconds one call of fn takes.
+template <typename Fn>
+double timeOnce(Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+// Seconds taken by the fastest of runs calls of fn.
+template <typename Fn>
+double bestOf(int runs, Fn fn) {
+    double best = 0;
+    for (int i = 0; i < runs; ++i) {
+        double seconds = timeOnce(fn);
+        if (i == 0 || seconds < best) best = seconds;
+    }
+    return best;
+}
+
+struct Timing {
+    double wall;
+    double cpu;     // process CPU time, all threads
+};
+
+// Wall and CPU seconds of the run with the shortest wall time out of
+// runs. Wall time well below CPU time is what parallelism looks like.
+template <typename Fn>
+Timing bestRun(int runs, Fn fn) {
+    Timing best{};
+    for (int i = 0; i < runs; ++i) {
+        std::clock_t start = std::clock();
+        double wall = timeOnce(fn);
+        double cpu = double(std::clock() - start) / CLOCKS_PER_SEC;
+        if (i == 0 || wall < best.wall) best = {wall, cpu};
+    }
+    return best;
+}
+
+constexpr double MB = 1e6;
+
+#endif
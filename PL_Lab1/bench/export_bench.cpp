@@ -0,0 +1,84 @@
+// Export time and output size per format, pretty against compact JSON.
+//
+// Usage: export_bench <source-file>
+// Parses the file repeated to about 16 MB once, then exports the tree as
+// DOT, JSON and compact JSON (best of 3 each) into a sink that only
+// counts the bytes, so the figures leave out the disk.
+
+#include "bench.h"
+#include "../include/parser.h"
+#include "../include/dot_export.h"
+#include "../include/json_export.h"
+
+#include <cstdio>
+#include <exception>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+namespace {
+
+constexpr size_t INPUT_SIZE = 16 * 1000 * 1000;
+
+// Discards what it is given, keeping the count.
+class CountingBuf : public std::streambuf {
+public:
+    size_t count = 0;
+
+protected:
+    std::streamsize xsputn(const char*, std::streamsize n) override {
+        count += static_cast<size_t>(n);
+        return n;
+    }
+    int_type overflow(int_type c) override {
+        if (!traits_type::eq_int_type(c, traits_type::eof())) count++;
+        return traits_type::not_eof(c);
+    }
+};
+
+template <typename Export>
+void run(const char* name, Export exportTo) {
+    size_t bytes = 0;
+    double seconds = bestOf(3, [&] {
+        CountingBuf sink;
+        std::ostream stream(&sink);
+        OutputBuffer out(stream);
+        exportTo(out);
+        out.flush();
+        bytes = sink.count;
+    });
+    std::printf("  %-13s %8.1f MB %7.3f s %9.1f MB/s\n", name, bytes / MB, seconds,
+                bytes / MB / seconds);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::fprintf(stderr, "Usage: %s <source-file>\n", argv[0]);
+        return 2;
+    }
+    try {
+        std::string text = repeatFile(argv[1], INPUT_SIZE);
+        Lexer lexer(text);
+        Parser parser(lexer);
+        ParseResult result = parser.parse();
+        const LineIndex& lines = lexer.lines();
+        const SymbolTable& symbols = lexer.symbols();
+
+        std::printf("Export (%.1f MB input):\n", text.size() / MB);
+        run("dot", [&](OutputBuffer& out) {
+            DotExporter::exportTree(result.tree, lines, symbols, out);
+        });
+        run("json", [&](OutputBuffer& out) {
+            JsonExporter::exportTree(result.tree, lines, symbols, out, JsonStyle::PRETTY);
+        });
+        run("json-compact", [&](OutputBuffer& out) {
+            JsonExporter::exportTree(result.tree, lines, symbols, out, JsonStyle::COMPACT);
+        });
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,79 @@
+// Parsing of expression-heavy code (precedence climbing).
+//
+// Usage: expression_bench <source-file>
+// Times lexing plus parsing, and parsing a token vector alone, over about
+// 20 MB of each input: the expression section of test/example.v4 wrapped
+// in a def, and the given file (test/precedence.v4 in `make bench`)
+// repeated. Built against the tree before precedence climbing, the
+// one-method-per-level chain parsed the first input in 0.46-0.62 s,
+// against 0.36-0.38 s for the loop right after it (same machine).
+
+#include "bench.h"
+#include "../include/parser.h"
+
+#include <cstdio>
+#include <exception>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr size_t INPUT_SIZE = 20 * 1000 * 1000;
+
+const char* const EXPRESSIONS =
+    "def f()\n"
+    "    result = (a + b) * c - d / e % f;\n"
+    "    bits_result = (a & b) | (c ^ d);\n"
+    "    shifted = a << 2;\n"
+    "    logic = (a > 0) && (b < 10) || !flag;\n"
+    "    neg = -x;\n"
+    "    inv = ~x;\n"
+    "    not_flag = !flag;\n"
+    "    x++;\n"
+    "    y--;\n"
+    "    r = add(x, y);\n"
+    "    z = foo(bar(1, 2), baz(3));\n"
+    "    val = arr[i];\n"
+    "    sub = arr[1..5];\n"
+    "end\n";
+
+std::string repeatText(const std::string& unit) {
+    std::string text;
+    text.reserve(INPUT_SIZE + unit.size());
+    while (text.size() < INPUT_SIZE) text += unit;
+    return text;
+}
+
+void run(const char* name, const std::string& text) {
+    double both = bestOf(3, [&] {
+        Lexer lexer(text);
+        Parser parser(lexer);
+        parser.parse();
+    });
+    Lexer lexer(text);
+    std::vector<Token> tokens = lexer.tokenize();
+    double parse = bestOf(3, [&] {
+        Parser parser(tokens);
+        parser.parse();
+    });
+    std::printf("  %-12s %6.1f MB  lex+parse %7.3f s  parse %7.3f s %7.1f Mtok/s\n", name,
+                text.size() / MB, both, parse, tokens.size() / MB / parse);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::fprintf(stderr, "Usage: %s <source-file>\n", argv[0]);
+        return 2;
+    }
+    try {
+        std::printf("Expression parsing:\n");
+        run("expressions", repeatText(EXPRESSIONS));
+        run("file", repeatFile(argv[1], INPUT_SIZE));
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,54 @@
+// Lexer throughput with the scan kernels this process selected.
+//
+// Usage: lexer_bench <source-file>
+// Times Lexer::tokenize() over three inputs of about 32 MB: the file
+// repeated, line comments, and string literals. `make bench` runs it once
+// per PL_LAB1_SIMD setting to compare the kernels.
+
+#include "bench.h"
+#include "../include/lexer.h"
+#include "../include/lexer_scan.h"
+
+#include <cstdio>
+#include <exception>
+#include <string>
+
+namespace {
+
+constexpr size_t INPUT_SIZE = 32 * 1000 * 1000;
+
+std::string repeatLine(const std::string& line) {
+    std::string text;
+    text.reserve(INPUT_SIZE + line.size());
+    while (text.size() < INPUT_SIZE) text += line;
+    return text;
+}
+
+void run(const char* name, const std::string& text) {
+    size_t tokens = 0;
+    double seconds = bestOf(5, [&] {
+        Lexer lexer(text);
+        tokens = lexer.tokenize().size();
+    });
+    std::printf("  %-10s %7.1f MB %9.1f MB/s %7.1f Mtok/s\n", name, text.size() / MB,
+                text.size() / MB / seconds, tokens / MB / seconds);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::fprintf(stderr, "Usage: %s <source-file>\n", argv[0]);
+        return 2;
+    }
+    try {
+        std::printf("Lexer, %s kernels:\n", selectScanKernels().name);
+        run("code", repeatFile(argv[1], INPUT_SIZE));
+        run("comments", repeatLine("    // a line comment that runs on for a while before the end\n"));
+        run("strings", repeatLine("    s = \"a string literal with \\\"escapes\\\" and some plain text\";\n"));
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,47 @@
+// Operator and punctuation lookup in the lexer.
+//
+// Usage: operator_bench
+// Times Lexer::next() over about 16 MB of each input: every operator
+// spelling separated by spaces, operators packed into expressions with
+// short identifiers, and identifiers alone for comparison (those take no
+// operator lookup but are interned, so they cost more per token).
+
+#include "bench.h"
+#include "../include/lexer.h"
+
+#include <cstdio>
+#include <string>
+
+namespace {
+
+constexpr size_t INPUT_SIZE = 16 * 1000 * 1000;
+
+std::string repeatLine(const std::string& line) {
+    std::string text;
+    text.reserve(INPUT_SIZE + line.size());
+    while (text.size() < INPUT_SIZE) text += line;
+    return text;
+}
+
+void run(const char* name, const std::string& text) {
+    size_t tokens = 0;
+    double seconds = bestOf(9, [&] {
+        Lexer lexer(text);
+        tokens = 0;
+        while (lexer.next().type != TokenType::TOK_EOF) ++tokens;
+    });
+    std::printf("  %-12s %9.1f Mtok/s %7.2f ns/token %9.1f MB/s\n", name, tokens / MB / seconds,
+                seconds * 1e9 / tokens, text.size() / MB / seconds);
+}
+
+} // namespace
+
+int main() {
+    std::printf("Operator lookup (Lexer::next()):\n");
+    run("operators", repeatLine("== != <= >= << >> && || ++ -- .. + - * / % & | ^ ~ ! < > = "
+                                "( ) [ ] { } , ;\n"));
+    run("expressions", repeatLine("x=(a+b)*c-d/e%f<<g>>h&i|j^~k&&!l||m<n<=o>p>=q==r!=s;"
+                                  "y[1..2]={t,u};z++;\n"));
+    run("identifiers", repeatLine("aa bb cc dd ee ff gg hh ii jj kk ll mm nn oo pp qq rr ss\n"));
+    return 0;
+}
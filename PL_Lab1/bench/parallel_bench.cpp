@@ -0,0 +1,57 @@
+// Scaling of parseParallel() with the number of threads.
+//
+// Usage: parallel_bench <source-file>
+// Lexes the file repeated to about 32 MB once, then times the sequential
+// Parser and parseParallel() on pools of 1, 2, 4, ... threads up to twice
+// the core count (best of 3 each). It prints the wall time, the process
+// CPU time and the speedup over the sequential parse. Wall time well
+// below CPU time is what parallelism looks like; when the two match, a
+// speedup comes from elsewhere (smaller per-range arenas, which are
+// cheaper to fault in), so the curve needs a machine with free cores.
+
+#include "bench.h"
+#include "../include/parallel_parser.h"
+
+#include <cstdio>
+#include <exception>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr size_t INPUT_SIZE = 32 * 1000 * 1000;
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::fprintf(stderr, "Usage: %s <source-file>\n", argv[0]);
+        return 2;
+    }
+    try {
+        std::string text = repeatFile(argv[1], INPUT_SIZE);
+        Lexer lexer(text);
+        std::vector<Token> tokens = lexer.tokenize();
+        size_t cores = std::thread::hardware_concurrency();
+
+        std::printf("Parallel parse (%.1f MB, %zu tokens, %zu cores):\n", text.size() / MB,
+                    tokens.size(), cores);
+        if (cores < 2) std::printf("  (fewer than 2 cores: no speedup below is from parallelism)\n");
+        Timing sequential = bestRun(3, [&] {
+            Parser parser(tokens);
+            parser.parse();
+        });
+        std::printf("  sequential  %7.3f s wall %7.3f s cpu\n", sequential.wall, sequential.cpu);
+        for (size_t jobs = 1; jobs <= 2 * (cores ? cores : 1); jobs *= 2) {
+            ThreadPool pool(jobs);
+            Timing parallel = bestRun(3, [&] { parseParallel(tokens, pool); });
+            std::printf("  jobs=%-5zu  %7.3f s wall %7.3f s cpu %5.2fx\n", jobs, parallel.wall,
+                        parallel.cpu, sequential.wall / parallel.wall);
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
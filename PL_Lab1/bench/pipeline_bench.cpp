@@ -0,0 +1,73 @@
+// Serial versus pipelined lexing (--pipeline, TokenPipe).
+//
+// Usage: pipeline_bench <source-file>
+// Times the file repeated to about 32 MB three ways, each with the Lexer
+// feeding the Parser directly and through a TokenPipe (best of 3): lex and
+// parse, lex and outline parse, and the whole processSource() run with
+// DOT export to /dev/null. Prints wall and process CPU time; the pipeline
+// can only gain when a second core is free to lex on.
+
+#include "bench.h"
+#include "../include/driver.h"
+#include "../include/token_pipe.h"
+
+#include <cstdio>
+#include <exception>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace {
+
+constexpr size_t INPUT_SIZE = 32 * 1000 * 1000;
+
+void parse(const std::string& text, bool outline, bool pipeline) {
+    ParserOptions options;
+    options.outline = outline;
+    Lexer lexer(text);
+    if (pipeline) {
+        TokenPipe pipe(lexer);
+        Parser(pipe, options).parse();
+    } else {
+        Parser(lexer, options).parse();
+    }
+}
+
+void process(const std::string& text, bool pipeline) {
+    DriverOptions options;
+    options.pipeline = pipeline;
+    std::ostringstream diagnostics;
+    processSource(SourceBuffer(text), "bench", "/dev/null", options, diagnostics);
+}
+
+void report(const char* name, Timing serial, Timing pipelined) {
+    std::printf("  %-10s serial %7.3f s wall %7.3f s cpu   pipeline %7.3f s wall %7.3f s cpu %5.2fx\n",
+                name, serial.wall, serial.cpu, pipelined.wall, pipelined.cpu,
+                serial.wall / pipelined.wall);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::fprintf(stderr, "Usage: %s <source-file>\n", argv[0]);
+        return 2;
+    }
+    try {
+        std::string text = repeatFile(argv[1], INPUT_SIZE);
+        size_t cores = std::thread::hardware_concurrency();
+
+        std::printf("Pipelined lexing (%.1f MB, %zu cores):\n", text.size() / MB, cores);
+        if (cores < 2) std::printf("  (fewer than 2 cores: lexing cannot overlap parsing)\n");
+        report("parse", bestRun(3, [&] { parse(text, false, false); }),
+               bestRun(3, [&] { parse(text, false, true); }));
+        report("outline", bestRun(3, [&] { parse(text, true, false); }),
+               bestRun(3, [&] { parse(text, true, true); }));
+        report("dot", bestRun(3, [&] { process(text, false); }),
+               bestRun(3, [&] { process(text, true); }));
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
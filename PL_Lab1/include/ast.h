@@ -1,16 +1,46 @@
 #ifndef AST_H
 #define AST_H
 
-#include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
+#include <memory_resource>
 #include "lexer.h"
 
 struct ASTNode;
-using ASTNodePtr = std::unique_ptr<ASTNode>;
+
+// Operation of an EXPR_BINARY or EXPR_UNARY node.
+enum class Operator : uint8_t {
+    NONE,
+    // Binary
+    ADD, SUB, MUL, DIV, MOD,
+    BIT_AND, BIT_OR, BIT_XOR, SHL, SHR,
+    LT, GT, LE, GE, EQ, NE,
+    AND, OR,
+    // Prefix
+    NEG, BIT_NOT, NOT, PRE_INC, PRE_DEC,
+    // Postfix
+    POST_INC, POST_DEC,
+};
+
+// Type named by a TYPE_BUILTIN node.
+enum class BuiltinType : uint8_t {
+    NONE,
+    BOOL, BYTE, INT, UINT, LONG, ULONG, CHAR, STRING,
+};
+
+// Keyword of a STMT_LOOP or STMT_REPEAT node.
+enum class LoopKind : uint8_t {
+    NONE,
+    WHILE,
+    UNTIL,
+};
+
+// Nodes are owned by the AstArena they were made in, not by their parent.
+using ASTNodePtr = ASTNode*;
 
 struct ASTNode {
-    enum Kind {
+    enum Kind : uint8_t {
         SOURCE,
         FUNC_DEF,
         FUNC_SIGNATURE,
@@ -39,15 +69,28 @@ struct ASTNode {
     };
 
     Kind kind;
+    // Set on EXPR_BINARY/EXPR_UNARY, TYPE_BUILTIN and STMT_LOOP/STMT_REPEAT
+    // nodes respectively (NONE elsewhere, and after a parse error); value
+    // is empty then. They fill what would be padding before symbol.
+    Operator op = Operator::NONE;
+    BuiltinType builtin = BuiltinType::NONE;
+    LoopKind loop = LoopKind::NONE;
+    // Identifier of FUNC_SIGNATURE, FUNC_ARG, TYPE_CUSTOM and EXPR_PLACE
+    // nodes, resolved through the Lexer's SymbolTable; value is empty then.
+    SymbolId symbol = NO_SYMBOL;
     SourceLocation loc;
-    std::string value;
-    std::vector<ASTNodePtr> children;
+    // Token text (literal spelling) viewed in the Lexer's source buffer,
+    // or a static string for synthesized values.
+    std::string_view value;
+    // Decoded value of EXPR_LITERAL and TYPE_ARRAY (dimension) nodes.
+    LiteralValue literal;
+    std::pmr::vector<ASTNodePtr> children;
 
-    ASTNode(Kind k, SourceLocation l, const std::string& v = "")
-        : kind(k), loc(l), value(v) {}
+    ASTNode(Kind k, SourceLocation l, std::string_view v, std::pmr::memory_resource* resource)
+        : kind(k), loc(l), value(v), children(resource) {}
 
     void addChild(ASTNodePtr child) {
-        children.push_back(std::move(child));
+        children.push_back(child);
     }
 
     static const char* kindName(Kind k) {
@@ -79,10 +122,108 @@ struct ASTNode {
     }
 
     const char* kindStr() const { return kindName(kind); }
+
+    static const char* operatorName(Operator op) {
+        switch (op) {
+            case Operator::NONE:      return nullptr;
+            case Operator::ADD:       return "+";
+            case Operator::SUB:       return "-";
+            case Operator::MUL:       return "*";
+            case Operator::DIV:       return "/";
+            case Operator::MOD:       return "%";
+            case Operator::BIT_AND:   return "&";
+            case Operator::BIT_OR:    return "|";
+            case Operator::BIT_XOR:   return "^";
+            case Operator::SHL:       return "<<";
+            case Operator::SHR:       return ">>";
+            case Operator::LT:        return "<";
+            case Operator::GT:        return ">";
+            case Operator::LE:        return "<=";
+            case Operator::GE:        return ">=";
+            case Operator::EQ:        return "==";
+            case Operator::NE:        return "!=";
+            case Operator::AND:       return "&&";
+            case Operator::OR:        return "||";
+            case Operator::NEG:       return "-";
+            case Operator::BIT_NOT:   return "~";
+            case Operator::NOT:       return "!";
+            case Operator::PRE_INC:   return "++";
+            case Operator::PRE_DEC:   return "--";
+            case Operator::POST_INC:  return "post++";
+            case Operator::POST_DEC:  return "post--";
+        }
+        return nullptr;
+    }
+
+    static const char* builtinTypeName(BuiltinType type) {
+        switch (type) {
+            case BuiltinType::NONE:   return nullptr;
+            case BuiltinType::BOOL:   return "bool";
+            case BuiltinType::BYTE:   return "byte";
+            case BuiltinType::INT:    return "int";
+            case BuiltinType::UINT:   return "uint";
+            case BuiltinType::LONG:   return "long";
+            case BuiltinType::ULONG:  return "ulong";
+            case BuiltinType::CHAR:   return "char";
+            case BuiltinType::STRING: return "string";
+        }
+        return nullptr;
+    }
+
+    static const char* loopKindName(LoopKind loop) {
+        switch (loop) {
+            case LoopKind::NONE:      return nullptr;
+            case LoopKind::WHILE:     return "while";
+            case LoopKind::UNTIL:     return "until";
+        }
+        return nullptr;
+    }
+
+    // Source spelling of whichever of op, builtin and loop is set, or
+    // nullptr if none is.
+    static const char* tagName(Operator op, BuiltinType builtin, LoopKind loop) {
+        if (op != Operator::NONE) return operatorName(op);
+        if (builtin != BuiltinType::NONE) return builtinTypeName(builtin);
+        return loopKindName(loop);
+    }
+
+    // Display text: the identifier name, the operator/type/loop spelling
+    // or value.
+    std::string_view text(const SymbolTable& symbols) const {
+        if (symbol != NO_SYMBOL) return symbols.name(symbol);
+        const char* tag = tagName(op, builtin, loop);
+        return tag ? std::string_view(tag) : value;
+    }
 };
 
-inline ASTNodePtr makeNode(ASTNode::Kind k, SourceLocation loc, const std::string& val = "") {
-    return std::make_unique<ASTNode>(k, loc, val);
-}
+// Owns every node of a tree and their children arrays. Memory comes from
+// large blocks and is released all at once when the arena is destroyed;
+// node destructors are never run, which is fine because everything a
+// node holds is either trivially destructible or lives in the arena.
+// Node text is not copied: it views the Lexer's buffer or static strings.
+class AstArena {
+public:
+    AstArena() : resource_(INITIAL_BLOCK_SIZE) {}
+    explicit AstArena(size_t initialBlockSize) : resource_(initialBlockSize) {}
+    AstArena(const AstArena&) = delete;
+    AstArena& operator=(const AstArena&) = delete;
+
+    ASTNodePtr makeNode(ASTNode::Kind k, SourceLocation loc, std::string_view val = {}) {
+        void* mem = resource_.allocate(sizeof(ASTNode), alignof(ASTNode));
+        return new (mem) ASTNode(k, loc, val, &resource_);
+    }
+
+    // Keeps other's nodes alive as long as this arena, for trees stitched
+    // together from subtrees built in separate arenas.
+    void adopt(std::unique_ptr<AstArena> other) {
+        adopted_.push_back(std::move(other));
+    }
+
+private:
+    static constexpr size_t INITIAL_BLOCK_SIZE = 64 * 1024;
+
+    std::pmr::monotonic_buffer_resource resource_;
+    std::vector<std::unique_ptr<AstArena>> adopted_;
+};
 
 #endif
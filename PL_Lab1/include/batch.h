@@ -0,0 +1,37 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "driver.h"
+#include "parse_cache.h"
+#include "thread_pool.h"
+#include <ostream>
+#include <string>
+#include <vector>
+
+// One input of a batch and the file its tree is written to.
+struct BatchFile {
+    std::string input;
+    std::string output;
+};
+
+// Expands the inputs named on the command line. A directory contributes
+// the *.v4 files under it, outputs keeping their relative paths; "@list"
+// contributes the paths in that file, one per line; anything else is a
+// source file. Outputs go to outputDir with the format's extension.
+// Throws std::runtime_error for an unreadable list or directory and when
+// two inputs would be written to the same output.
+std::vector<BatchFile> collectBatch(const std::vector<std::string>& inputs,
+                                    const std::string& outputDir, OutputFormat format);
+
+// Processes every file in one process, a pool task per file, largest
+// files first so a big one does not start last. Each file's diagnostics
+// are collected and written to diagnostics as one block, in the order of
+// files; a summary with the files that had errors goes to report, with
+// the statistics of cache when one is given. An output directory that
+// cannot be created is reported once, and its files count as failed.
+// Returns true when every file was parsed and written without errors.
+bool runBatch(const std::vector<BatchFile>& files, const DriverOptions& options,
+              ThreadPool& pool, std::ostream& diagnostics, std::ostream& report,
+              ParseCache* cache = nullptr);
+
+#endif
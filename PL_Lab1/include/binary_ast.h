@@ -0,0 +1,122 @@
+#ifndef BINARY_AST_H
+#define BINARY_AST_H
+
+#include "ast.h"
+#include "line_index.h"
+#include "source_buffer.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// On-disk AST written by BinaryExporter (--format=bin). The file is three
+// sections addressed from a fixed header, with no pointers, so a reader
+// can map it and walk it in place:
+//
+//   BinaryAstHeader
+//   BinaryNode[nodeCount]        preorder, like FlatAst
+//   BinaryString[stringCount]    offset/size into the bytes section
+//   bytes                        names, literal spellings and contents
+//
+// Integers are in the writer's byte order, which the header records.
+// Version 1.
+
+constexpr uint32_t BINARY_AST_VERSION = 1;
+constexpr uint32_t BINARY_AST_BYTE_ORDER = 0x01020304;
+constexpr char BINARY_AST_MAGIC[8] = {'V', '4', 'A', 'S', 'T', '\0', '\0', '\0'};
+constexpr uint32_t NO_STRING = UINT32_MAX;
+
+struct BinaryAstHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t nodeCount;
+    uint64_t nodesOffset;
+    uint64_t stringCount;
+    uint64_t stringsOffset;
+    uint64_t bytesOffset;
+    uint64_t bytesSize;
+};
+
+struct BinaryNode {
+    enum Flags : uint8_t {
+        HAS_SYMBOL = 1,     // text is an identifier (ASTNode::symbol)
+    };
+
+    uint64_t offset;        // SourceLocation
+    uint64_t line;          // resolved position, 1-based
+    uint64_t column;
+    uint64_t literal;       // LiteralValue::integer; string index for LIT_STRING
+    uint32_t childCount;
+    uint32_t end;           // index past the subtree, as FlatAst::end()
+    uint32_t text;          // string index of the name or value, or NO_STRING
+    uint8_t kind;           // ASTNode::Kind
+    // Operator, BuiltinType or LoopKind, by kind; 0 (NONE) elsewhere.
+    uint8_t tag;
+    uint8_t literalKind;    // LiteralKind
+    uint8_t flags;
+};
+
+struct BinaryString {
+    uint64_t offset;        // into the bytes section
+    uint64_t size;
+};
+
+static_assert(sizeof(BinaryAstHeader) == 64, "BinaryAstHeader layout");
+static_assert(sizeof(BinaryNode) == 48, "BinaryNode layout");
+static_assert(sizeof(BinaryString) == 16, "BinaryString layout");
+
+// Read-only view of a binary AST. Loading checks the header and the
+// section bounds only, so it costs O(1) plus the page faults of what is
+// actually read; large files are memory-mapped (SourceBuffer). Node
+// accessors mirror FlatAst. Throws std::runtime_error for a file that is
+// not a binary AST of this version and byte order.
+class BinaryAst {
+public:
+    static BinaryAst fromFile(const std::string& path);
+    explicit BinaryAst(SourceBuffer data);
+    BinaryAst(BinaryAst&& other) noexcept;
+    BinaryAst& operator=(BinaryAst&& other) noexcept;
+
+    uint32_t size() const { return static_cast<uint32_t>(header_->nodeCount); }
+    bool empty() const { return size() == 0; }
+
+    ASTNode::Kind kind(uint32_t i) const { return static_cast<ASTNode::Kind>(nodes_[i].kind); }
+    SourceLocation loc(uint32_t i) const { return {nodes_[i].offset}; }
+    LineColumn position(uint32_t i) const { return {nodes_[i].line, nodes_[i].column}; }
+    uint32_t end(uint32_t i) const { return nodes_[i].end; }
+    uint32_t childCount(uint32_t i) const { return nodes_[i].childCount; }
+    bool hasSymbol(uint32_t i) const { return nodes_[i].flags & BinaryNode::HAS_SYMBOL; }
+
+    Operator op(uint32_t i) const;
+    BuiltinType builtin(uint32_t i) const;
+    LoopKind loop(uint32_t i) const;
+    // String contents view the file.
+    LiteralValue literal(uint32_t i) const;
+    // Display text, as ASTNode::text().
+    std::string_view text(uint32_t i) const;
+
+    // Checks every node in O(n): its subtree ends after it and inside its
+    // parent's, node 0 spans the whole array, childCount matches the nodes
+    // that start directly inside it, and the kind and tag fields are in
+    // range. The accessors assume this holds; string indices are checked
+    // when read. Throws std::runtime_error naming the first bad node.
+    void validate() const;
+
+    // Rebuilds the pointer tree in arena, interning identifiers into
+    // symbols. Names, values and strings view this object's data, which
+    // has to outlive the tree and the table. Calls validate() first.
+    ASTNodePtr toTree(AstArena& arena, SymbolTable& symbols) const;
+
+private:
+    // Points the section pointers into data_ (already validated).
+    void bind();
+    std::string_view string(uint32_t index) const;
+
+    SourceBuffer data_;
+    const BinaryAstHeader* header_ = nullptr;
+    const BinaryNode* nodes_ = nullptr;
+    const BinaryString* strings_ = nullptr;
+    const char* bytes_ = nullptr;
+};
+
+#endif
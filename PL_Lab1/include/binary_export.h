@@ -0,0 +1,19 @@
+#ifndef BINARY_EXPORT_H
+#define BINARY_EXPORT_H
+
+#include "ast.h"
+#include "binary_ast.h"
+#include "line_index.h"
+#include "output_buffer.h"
+#include "symbol_table.h"
+
+// Writes the binary AST format described in binary_ast.h, for tools that
+// load the tree with BinaryAst instead of parsing text. Null children are
+// skipped, as in the other exporters.
+class BinaryExporter {
+public:
+    static void exportTree(const ASTNode* root, const LineIndex& lines,
+                           const SymbolTable& symbols, OutputBuffer& out);
+};
+
+#endif
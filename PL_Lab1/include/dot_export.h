@@ -2,17 +2,46 @@
 #define DOT_EXPORT_H
 
 #include "ast.h"
+#include "flat_ast.h"
+#include "line_index.h"
+#include "output_buffer.h"
+#include "symbol_table.h"
+#include "thread_pool.h"
 #include <string>
+#include <string_view>
 #include <ostream>
+#include <cstdint>
 
+// Writes nodes straight into an OutputBuffer as the tree is walked; the
+// string and stream overloads go through one as well.
 class DotExporter {
 public:
-    static std::string exportTree(const ASTNode* root);
-    static void exportTree(const ASTNode* root, std::ostream& out);
+    static void exportTree(const ASTNode* root, const LineIndex& lines,
+                           const SymbolTable& symbols, OutputBuffer& out);
+    // Same output, with the top-level items rendered on pool.
+    static void exportTree(const ASTNode* root, const LineIndex& lines,
+                           const SymbolTable& symbols, OutputBuffer& out, ThreadPool& pool);
+    static std::string exportTree(const ASTNode* root, const LineIndex& lines,
+                                  const SymbolTable& symbols);
+    static void exportTree(const ASTNode* root, const LineIndex& lines,
+                           const SymbolTable& symbols, std::ostream& out);
+    // Same output, produced by one linear pass over the flat layout.
+    static void exportTree(const FlatAst& ast, const LineIndex& lines,
+                           const SymbolTable& symbols, OutputBuffer& out);
+    static std::string exportTree(const FlatAst& ast, const LineIndex& lines,
+                                  const SymbolTable& symbols);
+    static void exportTree(const FlatAst& ast, const LineIndex& lines,
+                           const SymbolTable& symbols, std::ostream& out);
 
 private:
-    static void visitNode(const ASTNode* node, int& nextId, int parentId, std::ostream& out);
-    static std::string escape(const std::string& s);
+    static void writeHeader(OutputBuffer& out);
+    // Writes the subtree at root, numbering from firstId; returns the
+    // next free id.
+    static uint64_t writeSubtree(OutputBuffer& out, const ASTNode* root, uint64_t firstId,
+                                 int64_t parentId, const LineIndex& lines,
+                                 const SymbolTable& symbols);
+    static void writeNode(OutputBuffer& out, uint64_t id, int64_t parentId, const char* kind,
+                          std::string_view text, LineColumn pos);
 };
 
 #endif
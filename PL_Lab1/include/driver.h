@@ -0,0 +1,68 @@
+#ifndef DRIVER_H
+#define DRIVER_H
+
+#include "output_buffer.h"
+#include "parser.h"
+#include "source_buffer.h"
+#include "thread_pool.h"
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Part of ParseCache keys, and the only thing that tells a cache entry
+// written by an older build from a current one: an entry stores finished
+// output and diagnostics, and it is replayed as long as the key matches.
+// So bump it in the same change as anything that can alter, for some
+// input, the bytes of any output format (the exporters, BINARY_AST_VERSION),
+// the tree the parser builds or the diagnostics (the lexer, the parser and
+// its error recovery, message texts, the ParserOptions defaults). Changes
+// to the cache entry layout itself are covered by its magic instead.
+constexpr const char* PARSER_VERSION = "1.1";
+
+enum class OutputFormat { DOT, JSON, JSON_COMPACT, BIN };
+
+struct DriverOptions {
+    OutputFormat format = OutputFormat::DOT;
+    ParserOptions parser;
+    // Lex on a separate thread (TokenPipe); ignored when a pool is given,
+    // a combination the command line rejects.
+    bool pipeline = false;
+};
+
+// What processFile() did with one input.
+struct FileResult {
+    size_t errors = 0;      // lexer and parse diagnostics
+    bool written = false;   // the tree was exported
+    bool failed = false;    // the input could not be read or the output written
+};
+
+// Lexes, parses and exports one file: the whole job of the command line
+// tool. '-' names stdin or stdout. Diagnostics are written to
+// diagnostics as "path:line:column: ..." lines, I/O failures as
+// "Error: ..."; an output is written whenever the parser produced a
+// tree, errors or not. With a pool, tokens are materialized and both
+// parsing and export are split across it.
+FileResult processFile(const std::string& inputPath, const std::string& outputPath,
+                       const DriverOptions& options, std::ostream& diagnostics,
+                       ThreadPool* pool = nullptr);
+// processFile() for a source that is already loaded. located, when
+// given, also receives each diagnostic without the leading "path:", and
+// outputCopy a copy of the output as it is written (OutputBuffer::copyTo).
+FileResult processSource(SourceBuffer source, const std::string& inputPath,
+                         const std::string& outputPath, const DriverOptions& options,
+                         std::ostream& diagnostics, ThreadPool* pool = nullptr,
+                         std::vector<std::string>* located = nullptr,
+                         OutputBuffer* outputCopy = nullptr);
+
+// Loads a source file; '-' reads stdin. Throws std::runtime_error.
+SourceBuffer readSource(const std::string& path);
+// Opens an output file, truncating it; '-' is stdout. Throws
+// std::runtime_error.
+std::unique_ptr<OutputBuffer> openOutput(const std::string& path);
+
+// File extension for outputs of format, with the dot.
+const char* outputExtension(OutputFormat format);
+
+#endif
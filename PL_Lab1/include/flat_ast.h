@@ -0,0 +1,58 @@
+#ifndef FLAT_AST_H
+#define FLAT_AST_H
+
+#include "ast.h"
+#include <vector>
+#include <cstdint>
+
+// Node payload: everything an ASTNode carries besides kind, location and
+// children. Nodes without any share no entry (NO_PAYLOAD).
+struct FlatPayload {
+    Operator op;
+    BuiltinType builtin;
+    LoopKind loop;
+    SymbolId symbol;
+    std::string_view value;
+    LiteralValue literal;
+};
+
+// Compact AST stored as parallel arrays in preorder. The subtree of node
+// i is the index range [i + 1, end(i)): its first child (if any) is
+// i + 1 and each next sibling starts at the end of the previous one, so
+// a walk in index order visits the tree without chasing pointers.
+//
+// Offsets stay 64-bit like SourceLocation, so inputs over 4 GiB work.
+class FlatAst {
+public:
+    static constexpr uint32_t NO_PAYLOAD = UINT32_MAX;
+
+    // Preorder copy of the tree; null children are skipped.
+    static FlatAst fromTree(const ASTNode* root);
+    // Rebuilds an equivalent pointer tree in arena.
+    ASTNodePtr toTree(AstArena& arena) const;
+
+    uint32_t size() const { return static_cast<uint32_t>(kinds_.size()); }
+    bool empty() const { return kinds_.empty(); }
+
+    ASTNode::Kind kind(uint32_t i) const { return static_cast<ASTNode::Kind>(kinds_[i]); }
+    SourceLocation loc(uint32_t i) const { return {offsets_[i]}; }
+    uint32_t end(uint32_t i) const { return ends_[i]; }
+    bool hasChildren(uint32_t i) const { return ends_[i] > i + 1; }
+
+    const FlatPayload* payload(uint32_t i) const {
+        return payloads_[i] == NO_PAYLOAD ? nullptr : &payloadTable_[payloads_[i]];
+    }
+    // Display text, as ASTNode::text().
+    std::string_view text(uint32_t i, const SymbolTable& symbols) const;
+
+private:
+    uint32_t append(const ASTNode* node);
+
+    std::vector<uint8_t> kinds_;
+    std::vector<uint64_t> offsets_;
+    std::vector<uint32_t> payloads_;
+    std::vector<uint32_t> ends_;
+    std::vector<FlatPayload> payloadTable_;
+};
+
+#endif
@@ -2,18 +2,55 @@
 #define JSON_EXPORT_H
 
 #include "ast.h"
+#include "flat_ast.h"
+#include "line_index.h"
+#include "output_buffer.h"
+#include "symbol_table.h"
+#include "thread_pool.h"
 #include <string>
+#include <string_view>
 #include <ostream>
 
+enum class JsonStyle {
+    PRETTY,     // one member per line, indented two spaces per level
+    COMPACT,    // no whitespace at all, for machine consumers
+};
+
+// Writes nodes straight into an OutputBuffer as the tree is walked; the
+// string and stream overloads go through one as well.
 class JsonExporter {
 public:
-    static std::string exportTree(const ASTNode* root);
-    static void exportTree(const ASTNode* root, std::ostream& out);
+    static void exportTree(const ASTNode* root, const LineIndex& lines,
+                           const SymbolTable& symbols, OutputBuffer& out,
+                           JsonStyle style = JsonStyle::PRETTY);
+    // Same output, with the top-level items rendered on pool.
+    static void exportTree(const ASTNode* root, const LineIndex& lines,
+                           const SymbolTable& symbols, OutputBuffer& out, ThreadPool& pool,
+                           JsonStyle style = JsonStyle::PRETTY);
+    static std::string exportTree(const ASTNode* root, const LineIndex& lines,
+                                  const SymbolTable& symbols, JsonStyle style = JsonStyle::PRETTY);
+    static void exportTree(const ASTNode* root, const LineIndex& lines,
+                           const SymbolTable& symbols, std::ostream& out,
+                           JsonStyle style = JsonStyle::PRETTY);
+    // Same output, produced by one linear pass over the flat layout.
+    static void exportTree(const FlatAst& ast, const LineIndex& lines,
+                           const SymbolTable& symbols, OutputBuffer& out,
+                           JsonStyle style = JsonStyle::PRETTY);
+    static std::string exportTree(const FlatAst& ast, const LineIndex& lines,
+                                  const SymbolTable& symbols, JsonStyle style = JsonStyle::PRETTY);
+    static void exportTree(const FlatAst& ast, const LineIndex& lines,
+                           const SymbolTable& symbols, std::ostream& out,
+                           JsonStyle style = JsonStyle::PRETTY);
 
 private:
-    static void visitNode(const ASTNode* node, std::ostream& out, int indent);
-    static std::string escape(const std::string& s);
-    static void writeIndent(std::ostream& out, int indent);
+    static void writeSubtree(OutputBuffer& out, const ASTNode* root, int rootIndent,
+                             const LineIndex& lines, const SymbolTable& symbols, bool compact);
+    static void writeNodeHead(OutputBuffer& out, const char* kind, std::string_view text,
+                              LineColumn pos, int indent, bool compact);
+    static void writeChildrenOpen(OutputBuffer& out, int indent, bool compact);
+    static void writeChildrenClose(OutputBuffer& out, int indent, bool compact);
+    static void writeNodeClose(OutputBuffer& out, int indent, bool compact);
+    static void writeIndent(OutputBuffer& out, int indent);
 };
 
 #endif
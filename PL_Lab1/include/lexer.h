@@ -2,8 +2,15 @@
 #define LEXER_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <cstdint>
+#include "source_buffer.h"
+#include "lexer_scan.h"
+#include "line_index.h"
+#include "symbol_table.h"
+#include <memory>
+#include <memory_resource>
 
 enum class TokenType {
     TOK_DEC,        // [0-9]+
@@ -74,16 +81,43 @@ enum class TokenType {
     TOK_ERROR
 };
 
+// Byte offset into the source (64-bit, inputs may exceed 4 GiB). Line
+// and column are resolved on demand through the Lexer's LineIndex.
 struct SourceLocation {
-    int line;
-    int column;
-    int offset;
+    uint64_t offset;
 };
 
+enum class LiteralKind : uint8_t {
+    LIT_NONE,
+    LIT_INT,        // TOK_DEC, TOK_HEX, TOK_BITS
+    LIT_BOOL,       // TOK_TRUE, TOK_FALSE
+    LIT_CHAR,       // TOK_CHAR
+    LIT_STRING      // TOK_STRING
+};
+
+// Literal value decoded once by the Lexer. Kept to 16 bytes because
+// every Token and ASTNode carries one.
+struct LiteralValue {
+    LiteralKind kind = LiteralKind::LIT_NONE;
+    uint32_t size = 0;              // LIT_STRING length
+    union {
+        uint64_t integer = 0;       // LIT_INT value, LIT_BOOL 0 or 1, LIT_CHAR code point
+        const char* data;           // LIT_STRING contents
+    };
+
+    // LIT_STRING contents without quotes, escapes resolved. Views the
+    // source when there are no escapes, otherwise the Lexer's arena.
+    std::string_view string() const { return std::string_view(data, size); }
+};
+
+// Token text is a view into the Lexer's source buffer and stays valid
+// for as long as the Lexer that produced it.
 struct Token {
     TokenType type;
-    std::string text;
+    SymbolId symbol;        // TOK_IDENT only, NO_SYMBOL otherwise
+    std::string_view text;
     SourceLocation loc;
+    LiteralValue literal;
 };
 
 struct LexerError {
@@ -91,12 +125,55 @@ struct LexerError {
     SourceLocation loc;
 };
 
-class Lexer {
+// Pull interface for token producers. After TOK_EOF, next() keeps
+// returning TOK_EOF.
+class TokenSource {
 public:
-    explicit Lexer(const std::string& source);
+    virtual ~TokenSource() = default;
+    virtual Token next() = 0;
+};
+
+// Replays an already materialized token vector (ending with TOK_EOF).
+class TokenVectorSource : public TokenSource {
+public:
+    explicit TokenVectorSource(const std::vector<Token>& tokens, size_t start = 0)
+        : tokens_(tokens), pos_(start) {}
 
+    Token next() override {
+        const Token& tok = tokens_[pos_];
+        if (pos_ + 1 < tokens_.size()) pos_++;
+        return tok;
+    }
+
+private:
+    const std::vector<Token>& tokens_;
+    size_t pos_;
+};
+
+class Lexer : public TokenSource {
+public:
+    explicit Lexer(const std::string& source);
+    explicit Lexer(SourceBuffer source);
+    // Lexes a view the caller keeps alive, starting at byte start (which
+    // must be where a token or whitespace begins). Locations are offsets
+    // into the whole view.
+    Lexer(std::string_view source, uint64_t start);
+    Lexer(const Lexer&) = delete;
+    Lexer& operator=(const Lexer&) = delete;
+
+    // Produces tokens on demand; only the current lexing position is kept.
+    Token next() override;
+    // Materializes the whole token stream, ending with TOK_EOF.
     std::vector<Token> tokenize();
+    // Continues lexing at offset, the start of a token returned before
+    // (e.g. a function body an outline parse skipped). Identifiers keep
+    // their symbols and errors already reported are not repeated.
+    void restart(uint64_t offset);
     const std::vector<LexerError>& errors() const { return errors_; }
+    // Built on first use, for diagnostics and exporters.
+    const LineIndex& lines() const;
+    // Identifiers seen so far; complete once TOK_EOF has been returned.
+    const SymbolTable& symbols() const { return symbols_; }
 
 private:
     char peek() const;
@@ -104,20 +181,29 @@ private:
     char advance();
     bool isAtEnd() const;
     void skipWhitespaceAndComments();
+    void error(const std::string& msg, SourceLocation loc);
 
-    Token makeToken(TokenType type, const std::string& text, SourceLocation loc);
+    Token makeToken(TokenType type, size_t start, SourceLocation loc) const;
     Token readString();
     Token readChar();
     Token readNumber();
     Token readIdentOrKeyword();
+    void decodeInteger(Token& tok, size_t digitsStart, unsigned base);
+    std::string_view unescape(std::string_view body);
 
-    static TokenType keywordType(const std::string& word);
+    static TokenType keywordType(std::string_view word);
 
-    std::string source_;
+    SourceBuffer buffer_;
+    std::string_view source_;
+    const ScanKernels& scan_;
     size_t pos_;
-    int line_;
-    int col_;
     std::vector<LexerError> errors_;
+    // Errors located before this were reported before a restart().
+    uint64_t reportedUntil_ = 0;
+    mutable std::unique_ptr<LineIndex> lines_;
+    SymbolTable symbols_;
+    // Backing store for string literals whose escapes had to be resolved.
+    std::pmr::monotonic_buffer_resource strings_;
 };
 
 #endif
@@ -0,0 +1,36 @@
+#ifndef LEXER_SCAN_H
+#define LEXER_SCAN_H
+
+#include <cstddef>
+
+// Byte-run scanners used by the Lexer's fast paths. Each returns the
+// length of the run starting at p and never reads at or past end.
+// The implementation (scalar, SSE2 or AVX2) is chosen once at runtime.
+struct ScanKernels {
+    const char* name;
+
+    // ' ', '\t', '\r', '\n'
+    size_t (*whitespace)(const char* p, const char* end);
+    // [A-Za-z0-9_]
+    size_t (*identChars)(const char* p, const char* end);
+    // [0-9]
+    size_t (*digits)(const char* p, const char* end);
+    // up to the next '\n' (line comments, line index)
+    size_t (*untilNewline)(const char* p, const char* end);
+    // up to the next '/' or '*'
+    size_t (*blockComment)(const char* p, const char* end);
+    // up to the next '"' or '\\'
+    size_t (*stringBody)(const char* p, const char* end);
+};
+
+// Picks the widest implementation the CPU supports. Setting the
+// PL_LAB1_SIMD environment variable to "scalar", "sse2" or "avx2"
+// forces a narrower one (for benchmarking and testing).
+const ScanKernels& selectScanKernels();
+
+const ScanKernels& scalarScanKernels();
+// nullptr when the build target has no such implementation.
+const ScanKernels* sse2ScanKernels();
+const ScanKernels* avx2ScanKernels();
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef LINE_INDEX_H
+#define LINE_INDEX_H
+
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+struct LineColumn {
+    uint64_t line;
+    uint64_t column;
+};
+
+// Maps byte offsets to 1-based line/column pairs. Line starts are
+// collected in one pass over the source; each lookup is a binary search.
+// Columns count bytes, so a tab is one column.
+class LineIndex {
+public:
+    explicit LineIndex(std::string_view source);
+
+    LineColumn resolve(uint64_t offset) const;
+    size_t lineCount() const { return lineStarts_.size(); }
+
+private:
+    std::vector<uint64_t> lineStarts_;
+};
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef OUTPUT_BUFFER_H
+#define OUTPUT_BUFFER_H
+
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// Replacement text for each byte value, for writeEscaped(); an empty
+// entry leaves the byte as it is. Each output format builds its own with
+// makeEscapeTable().
+struct EscapeTable {
+    std::string_view replacement[256];
+};
+
+struct EscapeRule {
+    char byte;
+    std::string_view replacement;
+};
+
+constexpr EscapeTable makeEscapeTable(std::initializer_list<EscapeRule> rules) {
+    EscapeTable table{};
+    for (const EscapeRule& rule : rules) {
+        table.replacement[static_cast<unsigned char>(rule.byte)] = rule.replacement;
+    }
+    return table;
+}
+
+// Append-only output staged in one fixed-size buffer that is handed to
+// the sink each time it fills up, so writing a document of any size
+// needs only the buffer's memory. The sink is a file descriptor, a
+// std::ostream, or a std::string the output is appended to.
+//
+// Write errors are reported by flush(), which throws std::runtime_error;
+// the destructor flushes too but cannot report them, so call flush()
+// once the document is complete. After an error every later flush()
+// throws again, so an error is never lost in the middle of a document.
+class OutputBuffer {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 1024 * 1024;
+
+    // Creates or truncates the file at path.
+    explicit OutputBuffer(const std::string& path, size_t capacity = DEFAULT_CAPACITY);
+    // Writes to an open descriptor (e.g. 1 for stdout), left open.
+    explicit OutputBuffer(int fd, size_t capacity = DEFAULT_CAPACITY);
+    explicit OutputBuffer(std::ostream& out, size_t capacity = DEFAULT_CAPACITY);
+    explicit OutputBuffer(std::string& out, size_t capacity = DEFAULT_CAPACITY);
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+    ~OutputBuffer();
+
+    void write(std::string_view s) {
+        if (s.size() > capacity_ - size_) {
+            writeSlow(s);
+            return;
+        }
+        std::memcpy(data_.get() + size_, s.data(), s.size());
+        size_ += s.size();
+    }
+
+    void put(char c) {
+        if (size_ == capacity_) flush();
+        data_[size_++] = c;
+    }
+
+    // Decimal digits of value.
+    void writeNumber(uint64_t value);
+    // s with the bytes that table replaces escaped; the runs between them
+    // are copied with one write() each.
+    void writeEscaped(std::string_view s, const EscapeTable& table);
+
+    OutputBuffer& operator<<(std::string_view s) { write(s); return *this; }
+    OutputBuffer& operator<<(char c) { put(c); return *this; }
+    OutputBuffer& operator<<(uint64_t value) { writeNumber(value); return *this; }
+
+    // Hands everything buffered so far to the sink.
+    void flush();
+
+    // From now on also writes everything handed to the sink into copy
+    // (nullptr stops). A write error in copy stops the copying and is
+    // left for copy's own flush() to report; it does not fail this buffer.
+    void copyTo(OutputBuffer* copy) { copy_ = copy; }
+
+private:
+    void writeSlow(std::string_view s);
+    void writeToSink(const char* data, size_t size);
+
+    std::unique_ptr<char[]> data_;
+    size_t size_ = 0;
+    size_t capacity_;
+
+    int fd_ = -1;
+    bool ownsFd_ = false;
+    std::ostream* stream_ = nullptr;
+    std::string* string_ = nullptr;
+    std::string path_;
+    OutputBuffer* copy_ = nullptr;
+    bool failed_ = false;
+};
+
+#endif
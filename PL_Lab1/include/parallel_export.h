@@ -0,0 +1,27 @@
+#ifndef PARALLEL_EXPORT_H
+#define PARALLEL_EXPORT_H
+
+#include "ast.h"
+#include "output_buffer.h"
+#include "thread_pool.h"
+#include <cstdint>
+#include <functional>
+
+// Writes root->children[first, last) to out. firstNode is the preorder
+// index of the first of them (the root is 0, null children count for
+// nothing), for formats that number their nodes.
+using RenderItems =
+    std::function<void(OutputBuffer& out, size_t first, size_t last, uint64_t firstNode)>;
+
+// Renders the top-level items of root on pool and appends the results
+// to out in order, for exporters whose output for an item depends only
+// on the item and its preorder position. The caller writes what comes
+// before and after the items.
+//
+// Items are grouped into batches of similar node count, each rendered
+// into its own string; only a few batches per worker are in flight, so
+// memory stays bounded by the batch size rather than the document.
+void renderItemsParallel(const ASTNode* root, ThreadPool& pool, OutputBuffer& out,
+                         const RenderItems& render);
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef PARALLEL_PARSER_H
+#define PARALLEL_PARSER_H
+
+#include "parser.h"
+#include "thread_pool.h"
+#include <vector>
+
+// Parses a materialized token stream (ending with TOK_EOF) with the
+// top-level items split across pool. The tree and the error list are
+// identical to Parser(tokens, options).parse().
+//
+// The stream is cut speculatively at top-level-looking 'def' tokens and
+// each range is parsed on its own. Ranges are stitched in order; when a
+// range's last item runs past the next cut, the cuts it covered are
+// discarded and the gap is parsed sequentially, so a wrong guess only
+// costs time.
+ParseResult parseParallel(const std::vector<Token>& tokens, ThreadPool& pool,
+                          ParserOptions options = {});
+
+#endif
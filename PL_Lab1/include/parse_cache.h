@@ -0,0 +1,64 @@
+#ifndef PARSE_CACHE_H
+#define PARSE_CACHE_H
+
+#include "driver.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Key of a cache entry: a hash of the source bytes, PARSER_VERSION and
+// the options that affect the result.
+struct CacheKey {
+    uint64_t high;
+    uint64_t low;
+
+    std::string hex() const;
+};
+
+// Persistent content-addressed cache of processFile() results in a local
+// directory. An entry holds the exported output and the diagnostics
+// (without the input path, so a copy of a file under another name hits),
+// and a hit replays both without lexing or parsing. A miss copies the
+// output into the entry as it is exported, so storing never reads the
+// output file back. Entries are written to a temporary file and renamed
+// into place, so processes sharing the directory never see a partial
+// one; an entry that fails validation is treated as a miss and replaced.
+// Runs whose input or output failed, and outputs written to stdout, are
+// not stored. Safe to share between threads.
+class ParseCache {
+public:
+    explicit ParseCache(std::string dir);
+
+    // processFile() through the cache.
+    FileResult process(const std::string& inputPath, const std::string& outputPath,
+                       const DriverOptions& options, std::ostream& diagnostics,
+                       ThreadPool* pool = nullptr);
+
+    static CacheKey key(std::string_view source, const DriverOptions& options);
+
+    size_t hits() const { return hits_; }
+    size_t misses() const { return misses_; }
+    // Writes a "Cache: N hits, M misses" line.
+    void report(std::ostream& out) const;
+
+private:
+    std::string entryPath(const CacheKey& key) const;
+    // Replays the entry; false when it is missing or invalid, having
+    // written nothing.
+    bool replay(const std::string& path, const std::string& inputPath,
+                const std::string& outputPath, std::ostream& diagnostics,
+                FileResult& result) const;
+    void store(std::unique_ptr<OutputBuffer> entry, const std::string& temporary,
+               const std::string& path, const std::vector<std::string>& located,
+               const FileResult& result) const;
+
+    std::string dir_;
+    std::atomic<size_t> hits_{0};
+    std::atomic<size_t> misses_{0};
+};
+
+#endif
@@ -2,42 +2,139 @@
 #define PARSER_H
 
 #include "ast.h"
+#include "flat_ast.h"
 #include "lexer.h"
 #include <vector>
 #include <string>
+#include <memory>
+#include <cstdint>
 
 struct ParseError {
     std::string message;
     SourceLocation loc;
 };
 
+struct ParserOptions {
+    // Statements and expressions nested deeper than this stop the parse
+    // with a single ParseError instead of overflowing the call stack.
+    // Measured with g++ -O2 on x86-64, a level costs about 0.17 KiB of
+    // stack for blocks, 0.48 KiB for parentheses, and 1.14 KiB for
+    // parentheses inside a chain of all nine binary levels, where each
+    // level adds a parseExprBinary() frame. The default so needs up to
+    // about 4.6 MiB: the command line parses on ThreadPool threads,
+    // which get 8 MiB (ThreadPool::STACK_SIZE) whatever the main
+    // thread's limit. Other callers need as much stack or a lower limit.
+    size_t maxDepth = 4000;
+    // Parse function signatures only. Bodies are skipped at the token
+    // level and recorded in ParseResult::bodies, to be parsed on demand
+    // with Parser::parseBody().
+    bool outline = false;
+};
+
+// A function body skipped by an outline parse, closing 'end' included:
+// tokens [firstToken, firstToken + tokenCount) of the stream and bytes
+// [begin, end) of the source.
+struct BodyRange {
+    ASTNodePtr func;        // FUNC_DEF holding just its signature
+    size_t firstToken;
+    size_t tokenCount;
+    uint64_t begin;
+    uint64_t end;
+};
+
+struct FlatParseResult {
+    FlatAst ast;
+    std::vector<ParseError> errors;
+};
+
 struct ParseResult {
+    // Owns the nodes of tree.
+    std::unique_ptr<AstArena> arena;
     ASTNodePtr tree;
     std::vector<ParseError> errors;
+    // Outline mode only, in source order.
+    std::vector<BodyRange> bodies;
 };
 
 class Parser {
 public:
-    explicit Parser(const std::vector<Token>& tokens);
+    explicit Parser(const std::vector<Token>& tokens, ParserOptions options = {});
+    // Pulls tokens on demand (e.g. straight from a Lexer), keeping only a
+    // fixed window of them alive regardless of input size.
+    explicit Parser(TokenSource& source, ParserOptions options = {});
 
     ParseResult parse();
+    // Parses into the flat preorder layout; the intermediate pointer tree
+    // is freed before returning.
+    FlatParseResult parseFlat();
+    // Parses top-level items until at least minTokens tokens have been
+    // consumed or the input ends. The tree is a SOURCE node holding just
+    // those items; used to parse independent ranges of a token stream.
+    ParseResult parseSourceItems(size_t minTokens);
+    // Parses one top-level item into arena. Returns nullptr when the
+    // tokens there cannot start an item; they are skipped as after an
+    // error. Used to track items one by one (incremental reparsing).
+    ASTNodePtr parseItem(AstArena& arena);
+    // Parses a body an outline parse skipped into its FUNC_DEF, into
+    // arena (the outline result's). The parser must start at the body's
+    // first token: firstToken of the same token vector, or a Lexer
+    // restart()ed at begin.
+    void parseBody(const BodyRange& body, AstArena& arena);
+
+    // Tokens consumed so far.
+    size_t consumed() const { return head_; }
+    // True when the parse stopped at the depth limit.
+    bool aborted() const { return aborted_; }
+    bool isAtEnd() const;
+    const std::vector<ParseError>& errors() const { return errors_; }
+
+    // Byte offsets around the parse position: the end of the last
+    // consumed token (the current start before any), the start of the
+    // current token and the end of the lookahead token, the furthest one
+    // the parser may have examined.
+    uint64_t consumedEnd() const;
+    uint64_t currentOffset() const { return current().loc.offset; }
+    uint64_t lookaheadEnd() const;
 
 private:
+    // Counts one level of statement or expression nesting for its scope.
+    class DepthGuard {
+    public:
+        explicit DepthGuard(Parser& parser);
+        ~DepthGuard() { parser_.depth_--; }
+        DepthGuard(const DepthGuard&) = delete;
+        DepthGuard& operator=(const DepthGuard&) = delete;
+
+        bool tooDeep() const { return tooDeep_; }
+
+    private:
+        Parser& parser_;
+        bool tooDeep_;
+    };
+
+    ASTNodePtr makeNode(ASTNode::Kind k, SourceLocation loc, std::string_view val = {}) {
+        return arena_->makeNode(k, loc, val);
+    }
+
     const Token& current() const;
     const Token& peekToken() const;
     const Token& advance();
     bool check(TokenType type) const;
     bool match(TokenType type);
     const Token& expect(TokenType type, const std::string& context);
-    bool isAtEnd() const;
 
     void error(const std::string& msg);
     void error(const std::string& msg, SourceLocation loc);
     void synchronize();
+    void abortTooDeep();
 
-    ASTNodePtr parseSource();
+    ParseResult parseOwned(size_t minTokens);
+    ASTNodePtr parseSource(size_t minTokens = SIZE_MAX);
+    ASTNodePtr parseSourceStep();
     ASTNodePtr parseSourceItem();
     ASTNodePtr parseFuncDef();
+    void parseFuncBody(ASTNodePtr func);
+    void skipFuncBody(ASTNodePtr func);
     ASTNodePtr parseFuncSignature();
     ASTNodePtr parseFuncArg();
     ASTNodePtr parseTypeRef();
@@ -48,15 +145,7 @@ private:
     ASTNodePtr parseExpressionOrAssign();
     ASTNodePtr parseExpression();
 
-    ASTNodePtr parseExprOr();
-    ASTNodePtr parseExprAnd();
-    ASTNodePtr parseExprComparison();
-    ASTNodePtr parseExprBitOr();
-    ASTNodePtr parseExprBitXor();
-    ASTNodePtr parseExprBitAnd();
-    ASTNodePtr parseExprShift();
-    ASTNodePtr parseExprAdd();
-    ASTNodePtr parseExprMul();
+    ASTNodePtr parseExprBinary(int minPower);
     ASTNodePtr parseExprUnary();
     ASTNodePtr parseExprPostfix();
     ASTNodePtr parseExprPrimary();
@@ -64,9 +153,26 @@ private:
     bool isStatementStart() const;
     bool isExprStart() const;
 
-    const std::vector<Token>& tokens_;
-    size_t pos_;
+    // Ring of the token just consumed, the current token and one token of
+    // lookahead. A reference returned by advance() or expect() stays valid
+    // until the next advance().
+    static constexpr size_t WINDOW = 4;
+
+    std::unique_ptr<TokenSource> ownedSource_;
+    TokenSource& source_;
+    Token window_[WINDOW];
+    size_t head_;
     std::vector<ParseError> errors_;
+    std::vector<BodyRange> bodies_;
+    // Nodes go to arena_: ownedArena_ for parse(), the caller's arena for
+    // parseItem().
+    std::unique_ptr<AstArena> ownedArena_;
+    AstArena* arena_ = nullptr;
+    ParserOptions options_;
+    size_t depth_ = 0;
+    // Set once nesting exceeded maxDepth: the window is pinned at TOK_EOF
+    // so every open rule unwinds, and further errors are dropped.
+    bool aborted_ = false;
 };
 
 #endif // PARSER_H
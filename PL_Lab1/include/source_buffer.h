@@ -0,0 +1,42 @@
+#ifndef SOURCE_BUFFER_H
+#define SOURCE_BUFFER_H
+
+#include <string>
+#include <string_view>
+#include <istream>
+#include <cstddef>
+
+// Read-only source text, either owned in memory or mapped from a file.
+// Large regular files are memory-mapped so the lexer scans the mapped
+// pages directly; small files and streams are read into a string.
+class SourceBuffer {
+public:
+    SourceBuffer() = default;
+    explicit SourceBuffer(std::string text);
+    SourceBuffer(SourceBuffer&& other) noexcept;
+    SourceBuffer& operator=(SourceBuffer&& other) noexcept;
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+    ~SourceBuffer();
+
+    static SourceBuffer fromFile(const std::string& path);
+    static SourceBuffer fromStream(std::istream& in);
+
+    std::string_view view() const { return {data_, size_}; }
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool isMapped() const { return mapped_; }
+
+    // Files at least this large are mapped instead of read.
+    static constexpr size_t MAP_THRESHOLD = 64 * 1024;
+
+private:
+    void release();
+
+    std::string owned_;
+    const char* data_ = "";
+    size_t size_ = 0;
+    bool mapped_ = false;
+};
+
+#endif
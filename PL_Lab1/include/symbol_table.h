@@ -0,0 +1,37 @@
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+using SymbolId = uint32_t;
+
+// Sentinel for nodes and tokens that carry no identifier.
+constexpr SymbolId NO_SYMBOL = UINT32_MAX;
+
+// Per-parse identifier interner. Each distinct name gets a dense 32-bit
+// id in order of first appearance, so names compare as integers. Names
+// are views and must outlive the table (the Lexer interns views into its
+// own source buffer).
+class SymbolTable {
+public:
+    SymbolTable();
+
+    SymbolId intern(std::string_view name);
+    // NO_SYMBOL when name has not been interned.
+    SymbolId find(std::string_view name) const;
+    std::string_view name(SymbolId id) const { return names_[id]; }
+    size_t size() const { return names_.size(); }
+
+private:
+    SymbolId lookup(std::string_view name, uint32_t hash) const;
+    void grow();
+
+    // Open addressing, power-of-two capacity; slots hold id + 1, 0 is empty.
+    std::vector<uint32_t> slots_;
+    std::vector<std::string_view> names_;
+    std::vector<uint32_t> hashes_;
+};
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#endif
+
+// Fixed set of worker threads consuming a FIFO of tasks. submit() returns
+// a future for the task's result; an exception thrown by the task is
+// rethrown from future::get(). The destructor finishes queued tasks.
+class ThreadPool {
+public:
+    // Workers parse, which recurses once per nesting level (see
+    // ParserOptions::maxDepth), and default thread stacks can be as small
+    // as 512 KiB (macOS) or 1 MiB (Windows). std::thread cannot change
+    // that, so workers are native threads created with this much stack.
+    static constexpr size_t STACK_SIZE = 8 * 1024 * 1024;
+
+    // Throws std::system_error when a worker cannot be started.
+    explicit ThreadPool(size_t threads);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers_.size(); }
+
+    template <class F>
+    auto submit(F task) -> std::future<decltype(task())> {
+        using Result = decltype(task());
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::move(task));
+        std::future<Result> future = packaged->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.emplace_back([packaged]() { (*packaged)(); });
+        }
+        ready_.notify_one();
+        return future;
+    }
+
+private:
+#if defined(_WIN32)
+    using NativeThread = uintptr_t;     // HANDLE returned by _beginthreadex()
+    static unsigned __stdcall workerMain(void* pool);
+#else
+    using NativeThread = pthread_t;
+    static void* workerMain(void* pool);
+#endif
+
+    void run();
+    // Lets the workers finish the queue and joins them.
+    void stop();
+
+    std::vector<NativeThread> workers_;
+    std::deque<std::function<void()>> queue_;
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    bool stopping_ = false;
+};
+
+#endif
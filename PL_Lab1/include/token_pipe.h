@@ -0,0 +1,60 @@
+#ifndef TOKEN_PIPE_H
+#define TOKEN_PIPE_H
+
+#include "lexer.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+
+// Runs a token producer on its own thread, so lexing overlaps with
+// whatever consumes the tokens. Tokens travel in fixed-size batches
+// through a lock-free single-producer/single-consumer ring: the
+// producer publishes a filled batch by advancing written_, the consumer
+// hands it back by advancing read_, and each side only waits when the
+// ring is full or empty.
+//
+// The producer belongs to the pipe's thread until the pipe is destroyed
+// (or TOK_EOF has been read): only then may its errors, symbols and
+// lines be inspected. Destroying the pipe before TOK_EOF waits for the
+// producer to run through the rest of its stream unqueued, so (as after
+// Lexer::tokenize()) its errors cover the whole input.
+class TokenPipe : public TokenSource {
+public:
+    static constexpr size_t BATCH_TOKENS = 4096;
+    static constexpr size_t RING_BATCHES = 8;
+
+    explicit TokenPipe(TokenSource& producer);
+    ~TokenPipe();
+    TokenPipe(const TokenPipe&) = delete;
+    TokenPipe& operator=(const TokenPipe&) = delete;
+
+    // Consumer side; call from one thread only.
+    Token next() override;
+
+private:
+    struct Batch {
+        Token tokens[BATCH_TOKENS];
+        size_t size = 0;
+    };
+
+    void produce();
+
+    TokenSource& producer_;
+    std::unique_ptr<Batch[]> ring_;
+
+    // Batch counters; slot = counter % RING_BATCHES. Kept on separate
+    // cache lines so the two threads do not contend on one line.
+    alignas(64) std::atomic<size_t> written_{0};
+    alignas(64) std::atomic<size_t> read_{0};
+    std::atomic<bool> stopping_{false};
+
+    // Consumer state.
+    const Batch* current_ = nullptr;
+    size_t pos_ = 0;
+    bool atEof_ = false;
+    Token eof_{};
+
+    std::thread thread_;
+};
+
+#endif
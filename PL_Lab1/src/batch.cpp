@@ -0,0 +1,174 @@
+#include "../include/batch.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+
+static const char* const SOURCE_EXTENSION = ".v4";
+
+namespace {
+
+class BatchCollector {
+public:
+    BatchCollector(const std::string& outputDir, OutputFormat format)
+        : outputDir_(outputDir), extension_(outputExtension(format)) {}
+
+    void addFile(const fs::path& input, const fs::path& relative) {
+        fs::path output = (outputDir_ / relative).replace_extension(extension_).lexically_normal();
+        if (!outputs_.insert(output.string()).second) {
+            throw std::runtime_error("Two inputs would be written to " + output.string() +
+                                     ", the second is " + input.string());
+        }
+        files_.push_back({input.string(), output.string()});
+    }
+
+    void addDirectory(const fs::path& dir) {
+        std::vector<fs::path> found;
+        std::error_code ec;
+        for (fs::recursive_directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+            if (it->is_regular_file() && it->path().extension() == SOURCE_EXTENSION) {
+                found.push_back(it->path());
+            }
+        }
+        if (ec) throw std::runtime_error("Cannot read directory " + dir.string() + ": " + ec.message());
+        // Directory order is unspecified; sort so runs are repeatable.
+        std::sort(found.begin(), found.end());
+        for (const fs::path& path : found) addFile(path, path.lexically_relative(dir));
+    }
+
+    void addList(const std::string& listPath) {
+        std::ifstream list(listPath);
+        if (!list) throw std::runtime_error("Cannot open input list: " + listPath);
+        std::string line;
+        while (std::getline(list, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (!line.empty()) add(line);
+        }
+    }
+
+    void add(const std::string& input) {
+        if (input.size() > 1 && input[0] == '@') {
+            addList(input.substr(1));
+        } else if (std::error_code ec; fs::is_directory(input, ec)) {
+            addDirectory(input);
+        } else {
+            addFile(input, fs::path(input).filename());
+        }
+    }
+
+    std::vector<BatchFile> take() { return std::move(files_); }
+
+private:
+    fs::path outputDir_;
+    const char* extension_;
+    std::unordered_set<std::string> outputs_;
+    std::vector<BatchFile> files_;
+};
+
+struct BatchOutcome {
+    FileResult result;
+    std::string diagnostics;
+};
+
+} // namespace
+
+std::vector<BatchFile> collectBatch(const std::vector<std::string>& inputs,
+                                    const std::string& outputDir, OutputFormat format) {
+    BatchCollector collector(outputDir, format);
+    for (const std::string& input : inputs) collector.add(input);
+    return collector.take();
+}
+
+bool runBatch(const std::vector<BatchFile>& files, const DriverOptions& options,
+              ThreadPool& pool, std::ostream& diagnostics, std::ostream& report,
+              ParseCache* cache) {
+    // Output directories are created up front rather than by concurrent
+    // tasks. One that cannot be created is reported once, and its files
+    // are counted as failed without being processed.
+    std::unordered_map<std::string, bool> dirCreated;
+    std::vector<bool> skipped(files.size(), false);
+    for (size_t i = 0; i < files.size(); ++i) {
+        std::string dir = fs::path(files[i].output).parent_path().string();
+        if (dir.empty()) continue;
+        auto [it, inserted] = dirCreated.emplace(dir, true);
+        if (inserted) {
+            std::error_code ec;
+            fs::create_directories(dir, ec);
+            if (ec) {
+                it->second = false;
+                diagnostics << "Error: Cannot create output directory " << dir << ": "
+                            << ec.message() << "\n";
+            }
+        }
+        skipped[i] = !it->second;
+    }
+
+    std::vector<uintmax_t> sizes(files.size(), 0);
+    for (size_t i = 0; i < files.size(); ++i) {
+        std::error_code ec;
+        uintmax_t size = fs::file_size(files[i].input, ec);
+        if (!ec) sizes[i] = size;
+    }
+    std::vector<size_t> order(files.size());
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::stable_sort(order.begin(), order.end(),
+                     [&](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+
+    std::vector<std::future<BatchOutcome>> pending(files.size());
+    for (size_t i : order) {
+        if (skipped[i]) continue;
+        const BatchFile& file = files[i];
+        pending[i] = pool.submit([&file, &options, cache]() {
+            BatchOutcome outcome;
+            std::ostringstream text;
+            outcome.result = cache ? cache->process(file.input, file.output, options, text)
+                                   : processFile(file.input, file.output, options, text);
+            outcome.diagnostics = text.str();
+            return outcome;
+        });
+    }
+
+    size_t withErrors = 0;
+    size_t failed = 0;
+    std::vector<std::string> problems;
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (skipped[i]) {
+            failed++;
+            problems.push_back(files[i].input + ": failed (no output directory)");
+            continue;
+        }
+        BatchOutcome outcome;
+        try {
+            outcome = pending[i].get();
+        } catch (const std::exception& e) {
+            outcome.result.failed = true;
+            outcome.diagnostics = std::string("Error: ") + e.what() + "\n";
+        }
+        diagnostics << outcome.diagnostics;
+
+        const FileResult& result = outcome.result;
+        if (result.failed) {
+            failed++;
+            problems.push_back(files[i].input + ": failed");
+        } else if (result.errors > 0) {
+            withErrors++;
+            problems.push_back(files[i].input + ": " + std::to_string(result.errors) +
+                               (result.errors == 1 ? " error" : " errors"));
+        }
+    }
+    diagnostics.flush();
+
+    report << "Processed " << files.size() << " files: "
+           << files.size() - withErrors - failed << " without errors, "
+           << withErrors << " with errors, " << failed << " failed\n";
+    for (const std::string& problem : problems) report << "  " << problem << "\n";
+    if (cache) cache->report(report);
+    return withErrors == 0 && failed == 0;
+}
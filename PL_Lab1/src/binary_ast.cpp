@@ -0,0 +1,198 @@
+#include "../include/binary_ast.h"
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+static bool sectionFits(uint64_t offset, uint64_t count, uint64_t itemSize, uint64_t fileSize) {
+    return offset <= fileSize && count <= (fileSize - offset) / itemSize;
+}
+
+BinaryAst BinaryAst::fromFile(const std::string& path) {
+    return BinaryAst(SourceBuffer::fromFile(path));
+}
+
+BinaryAst::BinaryAst(SourceBuffer data) : data_(std::move(data)) {
+    uint64_t fileSize = data_.size();
+    if (fileSize < sizeof(BinaryAstHeader) ||
+        std::memcmp(data_.data(), BINARY_AST_MAGIC, sizeof(BINARY_AST_MAGIC)) != 0) {
+        throw std::runtime_error("Not a binary AST file");
+    }
+    if (reinterpret_cast<uintptr_t>(data_.data()) % alignof(BinaryAstHeader) != 0) {
+        throw std::runtime_error("Binary AST data is not aligned");
+    }
+    const auto* header = reinterpret_cast<const BinaryAstHeader*>(data_.data());
+    if (header->byteOrder != BINARY_AST_BYTE_ORDER) {
+        throw std::runtime_error("Binary AST was written with a different byte order");
+    }
+    if (header->version != BINARY_AST_VERSION) {
+        throw std::runtime_error("Unsupported binary AST version " +
+                                 std::to_string(header->version));
+    }
+    if (header->nodeCount > UINT32_MAX || header->stringCount > UINT32_MAX ||
+        header->nodesOffset % alignof(BinaryNode) != 0 ||
+        header->stringsOffset % alignof(BinaryString) != 0 ||
+        !sectionFits(header->nodesOffset, header->nodeCount, sizeof(BinaryNode), fileSize) ||
+        !sectionFits(header->stringsOffset, header->stringCount, sizeof(BinaryString), fileSize) ||
+        !sectionFits(header->bytesOffset, header->bytesSize, 1, fileSize)) {
+        throw std::runtime_error("Binary AST file is truncated or corrupt");
+    }
+    bind();
+}
+
+BinaryAst::BinaryAst(BinaryAst&& other) noexcept : data_(std::move(other.data_)) {
+    bind();
+    other.bind();
+}
+
+BinaryAst& BinaryAst::operator=(BinaryAst&& other) noexcept {
+    data_ = std::move(other.data_);
+    bind();
+    other.bind();
+    return *this;
+}
+
+void BinaryAst::bind() {
+    if (data_.size() < sizeof(BinaryAstHeader)) {
+        header_ = nullptr;
+        nodes_ = nullptr;
+        strings_ = nullptr;
+        bytes_ = nullptr;
+        return;
+    }
+    const char* base = data_.data();
+    header_ = reinterpret_cast<const BinaryAstHeader*>(base);
+    nodes_ = reinterpret_cast<const BinaryNode*>(base + header_->nodesOffset);
+    strings_ = reinterpret_cast<const BinaryString*>(base + header_->stringsOffset);
+    bytes_ = base + header_->bytesOffset;
+}
+
+// String entries are checked when read rather than at load, which keeps
+// loading O(1). A bad entry reads as empty.
+std::string_view BinaryAst::string(uint32_t index) const {
+    if (index >= header_->stringCount) return {};
+    const BinaryString& entry = strings_[index];
+    if (!sectionFits(entry.offset, entry.size, 1, header_->bytesSize)) return {};
+    return std::string_view(bytes_ + entry.offset, entry.size);
+}
+
+Operator BinaryAst::op(uint32_t i) const {
+    ASTNode::Kind k = kind(i);
+    if (k != ASTNode::EXPR_BINARY && k != ASTNode::EXPR_UNARY) return Operator::NONE;
+    return static_cast<Operator>(nodes_[i].tag);
+}
+
+BuiltinType BinaryAst::builtin(uint32_t i) const {
+    if (kind(i) != ASTNode::TYPE_BUILTIN) return BuiltinType::NONE;
+    return static_cast<BuiltinType>(nodes_[i].tag);
+}
+
+LoopKind BinaryAst::loop(uint32_t i) const {
+    ASTNode::Kind k = kind(i);
+    if (k != ASTNode::STMT_LOOP && k != ASTNode::STMT_REPEAT) return LoopKind::NONE;
+    return static_cast<LoopKind>(nodes_[i].tag);
+}
+
+LiteralValue BinaryAst::literal(uint32_t i) const {
+    const BinaryNode& node = nodes_[i];
+    LiteralValue value;
+    value.kind = static_cast<LiteralKind>(node.literalKind);
+    if (value.kind == LiteralKind::LIT_STRING) {
+        std::string_view contents = string(static_cast<uint32_t>(node.literal));
+        value.data = contents.data();
+        value.size = static_cast<uint32_t>(contents.size());
+    } else {
+        value.integer = node.literal;
+    }
+    return value;
+}
+
+std::string_view BinaryAst::text(uint32_t i) const {
+    if (const char* tag = ASTNode::tagName(op(i), builtin(i), loop(i))) return tag;
+    return string(nodes_[i].text);
+}
+
+static bool tagInRange(const BinaryNode& node) {
+    switch (node.kind) {
+        case ASTNode::EXPR_BINARY:
+        case ASTNode::EXPR_UNARY:
+            return node.tag <= static_cast<uint8_t>(Operator::POST_DEC);
+        case ASTNode::TYPE_BUILTIN:
+            return node.tag <= static_cast<uint8_t>(BuiltinType::STRING);
+        case ASTNode::STMT_LOOP:
+        case ASTNode::STMT_REPEAT:
+            return node.tag <= static_cast<uint8_t>(LoopKind::UNTIL);
+        default:
+            return true;
+    }
+}
+
+void BinaryAst::validate() const {
+    if (empty()) return;
+    auto corrupt = [](uint32_t i, const char* what) {
+        throw std::runtime_error("Binary AST node " + std::to_string(i) + " is corrupt: " + what);
+    };
+    if (end(0) != size()) corrupt(0, "the root does not span every node");
+
+    // Ancestors of node i: their subtree ends and the children seen so far.
+    struct Open {
+        uint32_t index;
+        uint32_t children;
+    };
+    std::vector<Open> open;
+    auto close = [&]() {
+        const Open& done = open.back();
+        if (done.children != childCount(done.index)) corrupt(done.index, "wrong child count");
+        open.pop_back();
+    };
+    for (uint32_t i = 0; i < size(); ++i) {
+        const BinaryNode& node = nodes_[i];
+        if (node.kind > ASTNode::EXPR_LITERAL) corrupt(i, "unknown kind");
+        if (!tagInRange(node)) corrupt(i, "unknown operator, type or loop keyword");
+        if (node.literalKind > static_cast<uint8_t>(LiteralKind::LIT_STRING)) {
+            corrupt(i, "unknown literal kind");
+        }
+        while (!open.empty() && end(open.back().index) <= i) close();
+        if (node.end <= i || node.end > size()) corrupt(i, "subtree end out of range");
+        if (!open.empty()) {
+            if (node.end > end(open.back().index)) corrupt(i, "subtree overruns its parent");
+            ++open.back().children;
+        }
+        open.push_back({i, 0});
+    }
+    while (!open.empty()) close();
+}
+
+ASTNodePtr BinaryAst::toTree(AstArena& arena, SymbolTable& symbols) const {
+    if (empty()) return nullptr;
+    validate();
+
+    // Ancestors of node i with their subtree ends, as FlatAst::toTree().
+    struct Open {
+        ASTNodePtr node;
+        uint32_t end;
+    };
+    std::vector<Open> open;
+    ASTNodePtr root = nullptr;
+    for (uint32_t i = 0; i < size(); ++i) {
+        while (!open.empty() && open.back().end <= i) open.pop_back();
+        ASTNodePtr node = arena.makeNode(kind(i), loc(i));
+        node->op = op(i);
+        node->builtin = builtin(i);
+        node->loop = loop(i);
+        node->literal = literal(i);
+        std::string_view name = string(nodes_[i].text);
+        if (hasSymbol(i)) {
+            node->symbol = symbols.intern(name);
+        } else {
+            node->value = name;
+        }
+        if (open.empty()) {
+            root = node;
+        } else {
+            open.back().node->addChild(node);
+        }
+        open.push_back({node, end(i)});
+    }
+    return root;
+}
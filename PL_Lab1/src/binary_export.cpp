@@ -0,0 +1,154 @@
+#include "../include/binary_export.h"
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// Strings of one export, each stored once. Identifiers are looked up by
+// symbol id, other text by content.
+class StringTable {
+public:
+    explicit StringTable(size_t symbolCount) : symbolStrings_(symbolCount, NO_STRING) {}
+
+    uint32_t addSymbol(SymbolId id, std::string_view name) {
+        if (symbolStrings_[id] == NO_STRING) symbolStrings_[id] = add(name);
+        return symbolStrings_[id];
+    }
+
+    uint32_t add(std::string_view s) {
+        auto inserted = byContent_.emplace(s, static_cast<uint32_t>(strings_.size()));
+        if (inserted.second) {
+            if (strings_.size() == NO_STRING) {
+                throw std::length_error("Too many strings for the binary AST format");
+            }
+            strings_.push_back(s);
+            bytes_ += s.size();
+        }
+        return inserted.first->second;
+    }
+
+    uint32_t find(std::string_view s) const { return byContent_.at(s); }
+
+    const std::vector<std::string_view>& strings() const { return strings_; }
+    uint64_t bytes() const { return bytes_; }
+
+private:
+    std::vector<uint32_t> symbolStrings_;
+    std::unordered_map<std::string_view, uint32_t> byContent_;
+    std::vector<std::string_view> strings_;
+    uint64_t bytes_ = 0;
+};
+
+uint8_t tagOf(const ASTNode& node) {
+    if (node.op != Operator::NONE) return static_cast<uint8_t>(node.op);
+    if (node.builtin != BuiltinType::NONE) return static_cast<uint8_t>(node.builtin);
+    return static_cast<uint8_t>(node.loop);
+}
+
+template <class T>
+void writeRecord(OutputBuffer& out, const T& record) {
+    out.write(std::string_view(reinterpret_cast<const char*>(&record), sizeof(record)));
+}
+
+} // namespace
+
+// Two preorder walks: the first numbers the nodes, records where each
+// subtree ends and collects the strings, which fixes every section's
+// offset; the second streams the node records. Only the per-node ends
+// and text indices are kept in memory, not the records.
+void BinaryExporter::exportTree(const ASTNode* root, const LineIndex& lines,
+                                const SymbolTable& symbols, OutputBuffer& out) {
+    StringTable strings(symbols.size());
+    std::vector<uint32_t> ends;
+    std::vector<uint32_t> texts;
+
+    auto addNode = [&](const ASTNode* node) {
+        if (ends.size() == UINT32_MAX) {
+            throw std::length_error("Too many nodes for the binary AST format");
+        }
+        uint32_t text = NO_STRING;
+        if (node->symbol != NO_SYMBOL) {
+            text = strings.addSymbol(node->symbol, symbols.name(node->symbol));
+        } else if (!node->value.empty()) {
+            text = strings.add(node->value);
+        }
+        if (node->literal.kind == LiteralKind::LIT_STRING) strings.add(node->literal.string());
+        texts.push_back(text);
+        ends.push_back(static_cast<uint32_t>(ends.size() + 1));
+        return static_cast<uint32_t>(ends.size() - 1);
+    };
+
+    struct Frame {
+        const ASTNode* node;
+        uint32_t index;
+        size_t nextChild;
+    };
+    std::vector<Frame> stack;
+    if (root) stack.push_back({root, addNode(root), 0});
+    while (!stack.empty()) {
+        Frame& top = stack.back();
+        if (top.nextChild == top.node->children.size()) {
+            ends[top.index] = static_cast<uint32_t>(ends.size());
+            stack.pop_back();
+            continue;
+        }
+        const ASTNode* child = top.node->children[top.nextChild++];
+        if (child) stack.push_back({child, addNode(child), 0});
+    }
+
+    BinaryAstHeader header{};
+    std::memcpy(header.magic, BINARY_AST_MAGIC, sizeof(header.magic));
+    header.version = BINARY_AST_VERSION;
+    header.byteOrder = BINARY_AST_BYTE_ORDER;
+    header.nodeCount = ends.size();
+    header.nodesOffset = sizeof(BinaryAstHeader);
+    header.stringCount = strings.strings().size();
+    header.stringsOffset = header.nodesOffset + header.nodeCount * sizeof(BinaryNode);
+    header.bytesOffset = header.stringsOffset + header.stringCount * sizeof(BinaryString);
+    header.bytesSize = strings.bytes();
+    writeRecord(out, header);
+
+    std::vector<const ASTNode*> pending;
+    if (root) pending.push_back(root);
+    uint32_t index = 0;
+    while (!pending.empty()) {
+        const ASTNode* node = pending.back();
+        pending.pop_back();
+
+        LineColumn pos = lines.resolve(node->loc.offset);
+        BinaryNode record{};
+        record.offset = node->loc.offset;
+        record.line = pos.line;
+        record.column = pos.column;
+        record.literalKind = static_cast<uint8_t>(node->literal.kind);
+        record.literal = node->literal.kind == LiteralKind::LIT_STRING
+                             ? strings.find(node->literal.string())
+                             : node->literal.integer;
+        record.end = ends[index];
+        record.text = texts[index];
+        record.kind = static_cast<uint8_t>(node->kind);
+        record.tag = tagOf(*node);
+        record.flags = node->symbol != NO_SYMBOL ? BinaryNode::HAS_SYMBOL : 0;
+
+        const auto& children = node->children;
+        for (auto it = children.rbegin(); it != children.rend(); ++it) {
+            if (*it) {
+                pending.push_back(*it);
+                record.childCount++;
+            }
+        }
+        writeRecord(out, record);
+        index++;
+    }
+
+    uint64_t offset = 0;
+    for (std::string_view s : strings.strings()) {
+        writeRecord(out, BinaryString{offset, s.size()});
+        offset += s.size();
+    }
+    for (std::string_view s : strings.strings()) {
+        out.write(s);
+    }
+}
@@ -1,58 +1,134 @@
 #include "../include/dot_export.h"
+#include "../include/parallel_export.h"
 #include <sstream>
+#include <vector>
 
-std::string DotExporter::escape(const std::string& s) {
-    std::string result;
-    result.reserve(s.size());
-    for (char c : s) {
-        switch (c) {
-            case '"':  result += "\\\""; break;
-            case '\\': result += "\\\\"; break;
-            case '\n': result += "\\n"; break;
-            case '\t': result += "\\t"; break;
-            default:   result += c; break;
-        }
-    }
-    return result;
-}
-
-void DotExporter::visitNode(const ASTNode* node, int& nextId, int parentId, std::ostream& out) {
-    int myId = nextId++;
+namespace {
 
-    std::string label = node->kindStr();
-    if (!node->value.empty()) {
-        label += "\\n" + escape(node->value);
-    }
-    label += "\\n[" + std::to_string(node->loc.line) + ":" + std::to_string(node->loc.column) + "]";
+constexpr EscapeTable DOT_ESCAPES = makeEscapeTable({
+    {'"', "\\\""}, {'\\', "\\\\"}, {'\n', "\\n"}, {'\t', "\\t"},
+});
 
-    out << "  n" << myId << " [label=\"" << label << "\"];\n";
+} // namespace
 
-    if (parentId >= 0) {
-        out << "  n" << parentId << " -> n" << myId << ";\n";
+void DotExporter::writeNode(OutputBuffer& out, uint64_t id, int64_t parentId, const char* kind,
+                            std::string_view text, LineColumn pos) {
+    out << "  n" << id << " [label=\"" << kind;
+    if (!text.empty()) {
+        out << "\\n";
+        out.writeEscaped(text, DOT_ESCAPES);
     }
+    out << "\\n[" << pos.line << ':' << pos.column << "]\"];\n";
 
-    for (const auto& child : node->children) {
-        if (child) {
-            visitNode(child.get(), nextId, myId, out);
-        }
+    if (parentId >= 0) {
+        out << "  n" << static_cast<uint64_t>(parentId) << " -> n" << id << ";\n";
     }
 }
 
-void DotExporter::exportTree(const ASTNode* root, std::ostream& out) {
+void DotExporter::writeHeader(OutputBuffer& out) {
     out << "digraph AST {\n";
     out << "  node [shape=box, fontname=\"monospace\", fontsize=10];\n";
     out << "  edge [arrowsize=0.7];\n";
+}
+
+// Preorder walk with an explicit stack, so nesting depth is bounded by
+// memory rather than by the call stack.
+uint64_t DotExporter::writeSubtree(OutputBuffer& out, const ASTNode* root, uint64_t firstId,
+                                   int64_t parentId, const LineIndex& lines,
+                                   const SymbolTable& symbols) {
+    struct Pending {
+        const ASTNode* node;
+        int64_t parentId;
+    };
+    std::vector<Pending> stack;
+    if (root) stack.push_back({root, parentId});
+
+    uint64_t nextId = firstId;
+    while (!stack.empty()) {
+        Pending item = stack.back();
+        stack.pop_back();
+
+        uint64_t id = nextId++;
+        writeNode(out, id, item.parentId, item.node->kindStr(), item.node->text(symbols),
+                  lines.resolve(item.node->loc.offset));
+
+        const auto& children = item.node->children;
+        for (auto it = children.rbegin(); it != children.rend(); ++it) {
+            if (*it) stack.push_back({*it, static_cast<int64_t>(id)});
+        }
+    }
+    return nextId;
+}
 
-    if (root) {
-        int nextId = 0;
-        visitNode(root, nextId, -1, out);
+void DotExporter::exportTree(const ASTNode* root, const LineIndex& lines,
+                             const SymbolTable& symbols, OutputBuffer& out) {
+    writeHeader(out);
+    writeSubtree(out, root, 0, -1, lines, symbols);
+    out << "}\n";
+}
+
+// Node ids are preorder indices, so the items' subtree sizes fix where
+// each item's ids start and the batches can be numbered independently.
+void DotExporter::exportTree(const ASTNode* root, const LineIndex& lines,
+                             const SymbolTable& symbols, OutputBuffer& out, ThreadPool& pool) {
+    if (!root || pool.size() <= 1) {
+        exportTree(root, lines, symbols, out);
+        return;
+    }
+    writeHeader(out);
+    writeNode(out, 0, -1, root->kindStr(), root->text(symbols), lines.resolve(root->loc.offset));
+    renderItemsParallel(root, pool, out,
+        [&](OutputBuffer& chunk, size_t first, size_t last, uint64_t firstNode) {
+            uint64_t id = firstNode;
+            for (size_t i = first; i < last; ++i) {
+                id = writeSubtree(chunk, root->children[i], id, 0, lines, symbols);
+            }
+        });
+    out << "}\n";
+}
+
+void DotExporter::exportTree(const ASTNode* root, const LineIndex& lines,
+                             const SymbolTable& symbols, std::ostream& out) {
+    OutputBuffer buffer(out);
+    exportTree(root, lines, symbols, buffer);
+    buffer.flush();
+}
+
+std::string DotExporter::exportTree(const ASTNode* root, const LineIndex& lines,
+                                    const SymbolTable& symbols) {
+    std::ostringstream oss;
+    exportTree(root, lines, symbols, oss);
+    return oss.str();
+}
+
+// Node ids are preorder indices, which is exactly the flat layout, so the
+// walk only has to track the chain of open ancestors for the edges.
+void DotExporter::exportTree(const FlatAst& ast, const LineIndex& lines,
+                             const SymbolTable& symbols, OutputBuffer& out) {
+    writeHeader(out);
+
+    std::vector<uint32_t> ancestors;
+    for (uint32_t i = 0; i < ast.size(); ++i) {
+        while (!ancestors.empty() && ast.end(ancestors.back()) <= i) ancestors.pop_back();
+        int64_t parentId = ancestors.empty() ? -1 : static_cast<int64_t>(ancestors.back());
+        writeNode(out, i, parentId, ASTNode::kindName(ast.kind(i)), ast.text(i, symbols),
+                  lines.resolve(ast.loc(i).offset));
+        ancestors.push_back(i);
     }
 
     out << "}\n";
 }
 
-std::string DotExporter::exportTree(const ASTNode* root) {
+void DotExporter::exportTree(const FlatAst& ast, const LineIndex& lines,
+                             const SymbolTable& symbols, std::ostream& out) {
+    OutputBuffer buffer(out);
+    exportTree(ast, lines, symbols, buffer);
+    buffer.flush();
+}
+
+std::string DotExporter::exportTree(const FlatAst& ast, const LineIndex& lines,
+                                    const SymbolTable& symbols) {
     std::ostringstream oss;
-    exportTree(root, oss);
+    exportTree(ast, lines, symbols, oss);
     return oss.str();
 }
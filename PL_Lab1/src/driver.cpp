@@ -0,0 +1,132 @@
+#include "../include/driver.h"
+#include "../include/lexer.h"
+#include "../include/source_buffer.h"
+#include "../include/parallel_parser.h"
+#include "../include/token_pipe.h"
+#include "../include/dot_export.h"
+#include "../include/json_export.h"
+#include "../include/binary_export.h"
+
+#include <iostream>
+#include <memory>
+
+static const int STDOUT_FD = 1;
+
+SourceBuffer readSource(const std::string& path) {
+    if (path == "-") {
+        return SourceBuffer::fromStream(std::cin);
+    }
+    return SourceBuffer::fromFile(path);
+}
+
+std::unique_ptr<OutputBuffer> openOutput(const std::string& path) {
+    if (path == "-") {
+        std::cout.flush();
+        return std::make_unique<OutputBuffer>(STDOUT_FD);
+    }
+    return std::make_unique<OutputBuffer>(path);
+}
+
+FileResult processFile(const std::string& inputPath, const std::string& outputPath,
+                       const DriverOptions& options, std::ostream& diagnostics,
+                       ThreadPool* pool) {
+    SourceBuffer source;
+    try {
+        source = readSource(inputPath);
+    } catch (const std::exception& e) {
+        diagnostics << "Error: " << e.what() << "\n";
+        FileResult outcome;
+        outcome.failed = true;
+        return outcome;
+    }
+    return processSource(std::move(source), inputPath, outputPath, options, diagnostics, pool);
+}
+
+FileResult processSource(SourceBuffer source, const std::string& inputPath,
+                         const std::string& outputPath, const DriverOptions& options,
+                         std::ostream& diagnostics, ThreadPool* pool,
+                         std::vector<std::string>* located, OutputBuffer* outputCopy) {
+    FileResult outcome;
+
+    // Single-threaded, the parser pulls tokens from the lexer on demand,
+    // so no token vector is materialized. Parallel parsing needs random
+    // access and lexes everything first. With --pipeline the lexer runs
+    // ahead on its own thread instead. Either way lexer errors are
+    // complete once parsing is done.
+    Lexer lexer(std::move(source));
+    ParseResult result;
+    if (pool) {
+        std::vector<Token> tokens = lexer.tokenize();
+        result = parseParallel(tokens, *pool, options.parser);
+    } else if (options.pipeline) {
+        TokenPipe pipe(lexer);
+        Parser parser(pipe, options.parser);
+        result = parser.parse();
+    } else {
+        Parser parser(lexer, options.parser);
+        result = parser.parse();
+    }
+
+    // Each diagnostic is "path:line:column: ..."; the text may span lines.
+    auto report = [&](SourceLocation loc, const char* what, const std::string& message) {
+        LineColumn pos = lexer.lines().resolve(loc.offset);
+        std::string text = std::to_string(pos.line) + ":" + std::to_string(pos.column) + ": " +
+                           what + ": " + message;
+        diagnostics << inputPath << ":" << text << "\n";
+        if (located) located->push_back(std::move(text));
+        outcome.errors++;
+    };
+    for (const auto& err : lexer.errors()) report(err.loc, "lexer error", err.message);
+    for (const auto& err : result.errors) report(err.loc, "parse error", err.message);
+
+    if (result.tree) {
+        // The exporters stream into the buffer, which is flushed to the
+        // file as it fills, so the document is never held in memory.
+        try {
+            std::unique_ptr<OutputBuffer> out = openOutput(outputPath);
+            out->copyTo(outputCopy);
+            const LineIndex& lines = lexer.lines();
+            switch (options.format) {
+                case OutputFormat::DOT:
+                    if (pool) {
+                        DotExporter::exportTree(result.tree, lines, lexer.symbols(), *out, *pool);
+                    } else {
+                        DotExporter::exportTree(result.tree, lines, lexer.symbols(), *out);
+                    }
+                    break;
+                case OutputFormat::JSON:
+                case OutputFormat::JSON_COMPACT: {
+                    JsonStyle style = options.format == OutputFormat::JSON ? JsonStyle::PRETTY
+                                                                           : JsonStyle::COMPACT;
+                    if (pool) {
+                        JsonExporter::exportTree(result.tree, lines, lexer.symbols(), *out, *pool,
+                                                 style);
+                    } else {
+                        JsonExporter::exportTree(result.tree, lines, lexer.symbols(), *out, style);
+                    }
+                    break;
+                }
+                case OutputFormat::BIN:
+                    BinaryExporter::exportTree(result.tree, lines, lexer.symbols(), *out);
+                    break;
+            }
+            out->flush();
+        } catch (const std::exception& e) {
+            diagnostics << "Error: " << e.what() << "\n";
+            outcome.failed = true;
+            return outcome;
+        }
+        outcome.written = true;
+    }
+    return outcome;
+}
+
+const char* outputExtension(OutputFormat format) {
+    switch (format) {
+        case OutputFormat::DOT:          return ".dot";
+        case OutputFormat::JSON:
+        case OutputFormat::JSON_COMPACT: return ".json";
+        case OutputFormat::BIN:          return ".ast";
+    }
+    return "";
+}
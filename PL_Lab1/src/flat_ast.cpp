@@ -0,0 +1,85 @@
+#include "../include/flat_ast.h"
+
+FlatAst FlatAst::fromTree(const ASTNode* root) {
+    FlatAst ast;
+    if (!root) return ast;
+
+    // Explicit stack so deep trees do not recurse: each entry is a node
+    // whose index is assigned and whose children are still being copied.
+    struct Frame {
+        const ASTNode* node;
+        uint32_t index;
+        size_t nextChild;
+    };
+    std::vector<Frame> stack;
+    stack.push_back({root, ast.append(root), 0});
+
+    while (!stack.empty()) {
+        Frame& top = stack.back();
+        if (top.nextChild == top.node->children.size()) {
+            ast.ends_[top.index] = ast.size();
+            stack.pop_back();
+            continue;
+        }
+        const ASTNode* child = top.node->children[top.nextChild++];
+        if (child) stack.push_back({child, ast.append(child), 0});
+    }
+    return ast;
+}
+
+uint32_t FlatAst::append(const ASTNode* node) {
+    uint32_t index = size();
+    kinds_.push_back(static_cast<uint8_t>(node->kind));
+    offsets_.push_back(node->loc.offset);
+    ends_.push_back(index + 1);
+
+    if (node->symbol == NO_SYMBOL && node->value.empty() &&
+        node->literal.kind == LiteralKind::LIT_NONE && node->op == Operator::NONE &&
+        node->builtin == BuiltinType::NONE && node->loop == LoopKind::NONE) {
+        payloads_.push_back(NO_PAYLOAD);
+    } else {
+        payloads_.push_back(static_cast<uint32_t>(payloadTable_.size()));
+        payloadTable_.push_back({node->op, node->builtin, node->loop, node->symbol,
+                                 node->value, node->literal});
+    }
+    return index;
+}
+
+ASTNodePtr FlatAst::toTree(AstArena& arena) const {
+    if (empty()) return nullptr;
+
+    // Ancestors of node i with their subtree ends.
+    struct Open {
+        ASTNodePtr node;
+        uint32_t end;
+    };
+    std::vector<Open> open;
+    ASTNodePtr root = nullptr;
+    for (uint32_t i = 0; i < size(); ++i) {
+        while (!open.empty() && open.back().end <= i) open.pop_back();
+        ASTNodePtr node = arena.makeNode(kind(i), loc(i));
+        if (const FlatPayload* p = payload(i)) {
+            node->op = p->op;
+            node->builtin = p->builtin;
+            node->loop = p->loop;
+            node->symbol = p->symbol;
+            node->value = p->value;
+            node->literal = p->literal;
+        }
+        if (open.empty()) {
+            root = node;
+        } else {
+            open.back().node->addChild(node);
+        }
+        open.push_back({node, ends_[i]});
+    }
+    return root;
+}
+
+std::string_view FlatAst::text(uint32_t i, const SymbolTable& symbols) const {
+    const FlatPayload* p = payload(i);
+    if (!p) return {};
+    if (p->symbol != NO_SYMBOL) return symbols.name(p->symbol);
+    const char* tag = ASTNode::tagName(p->op, p->builtin, p->loop);
+    return tag ? std::string_view(tag) : p->value;
+}
@@ -0,0 +1,250 @@
+#include "../include/incremental_parser.h"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+
+// The lexer reads one byte past a token to find where it ends.
+static const uint64_t LEXER_LOOKAHEAD = 1;
+// Most reparses cover a single function, so generations start small.
+static const size_t GENERATION_BLOCK_SIZE = 4 * 1024;
+
+// What the items of one reparse point into: their nodes, a copy of the
+// source bytes they were parsed from and unescaped string literals.
+// Freed with the last of those items.
+struct IncrementalParser::Generation {
+    AstArena arena{GENERATION_BLOCK_SIZE};
+    std::string text;
+    std::pmr::monotonic_buffer_resource strings;
+};
+
+namespace {
+
+// Visits every node under root with an explicit stack, like the
+// exporters, so deep trees do not recurse.
+template <class Visit>
+void forEachNode(ASTNodePtr root, Visit visit) {
+    if (!root) return;
+    std::vector<ASTNodePtr> stack{root};
+    while (!stack.empty()) {
+        ASTNodePtr node = stack.back();
+        stack.pop_back();
+        visit(*node);
+        for (ASTNodePtr child : node->children) {
+            if (child) stack.push_back(child);
+        }
+    }
+}
+
+uint64_t shifted(uint64_t offset, int64_t delta) {
+    return offset + static_cast<uint64_t>(delta);
+}
+
+} // namespace
+
+IncrementalParser::IncrementalParser(std::string source, ParserOptions options)
+    : text_(std::move(source)), options_(options) {
+    root_ = rootArena_.makeNode(ASTNode::SOURCE, {0});
+    reparse(0, UINT64_MAX, 0);
+}
+
+IncrementalParser::~IncrementalParser() = default;
+
+void IncrementalParser::update(const std::vector<TextEdit>& edits) {
+    // Check every edit up front so a bad one leaves the text untouched.
+    uint64_t size = text_.size();
+    for (const TextEdit& edit : edits) {
+        if (edit.offset > size || edit.length > size - edit.offset) {
+            throw std::out_of_range("Text edit out of range");
+        }
+        size = size - edit.length + edit.text.size();
+    }
+    for (const TextEdit& edit : edits) {
+        applyEdit(edit);
+    }
+}
+
+void IncrementalParser::applyEdit(const TextEdit& edit) {
+    uint64_t editEnd = edit.offset + edit.length;
+    int64_t delta = static_cast<int64_t>(edit.text.size()) - static_cast<int64_t>(edit.length);
+    text_.replace(edit.offset, edit.length, edit.text);
+    lines_.reset();
+
+    // dependsUntil grows with the item index.
+    auto affected = std::partition_point(items_.begin(), items_.end(),
+        [&](const Item& item) { return item.dependsUntil <= edit.offset; });
+    reparse(static_cast<size_t>(affected - items_.begin()), editEnd, delta);
+}
+
+void IncrementalParser::reparse(size_t keep, uint64_t reusableFrom, int64_t delta) {
+    uint64_t start = keep > 0 ? items_[keep - 1].end : 0;
+    Lexer lexer(text_, start);
+    Parser parser(lexer, options_);
+    auto generation = std::make_shared<Generation>();
+
+    // Old items that begin after the edit: their bytes are unchanged, so
+    // the parse can stop as soon as it reaches one of them.
+    size_t next = static_cast<size_t>(
+        std::partition_point(items_.begin() + keep, items_.end(),
+            [&](const Item& item) { return item.begin < reusableFrom; }) - items_.begin());
+    bool synced = false;
+
+    std::vector<Item> fresh;
+    while (!parser.isAtEnd()) {
+        size_t errorCount = parser.errors().size();
+        Item item;
+        item.begin = parser.currentOffset();
+        item.node = parser.parseItem(generation->arena);
+        item.end = parser.consumedEnd();
+        // After the depth limit the rest of the input was never looked at.
+        item.dependsUntil = parser.aborted() ? UINT64_MAX : parser.lookaheadEnd() + LEXER_LOOKAHEAD;
+        item.errors.assign(parser.errors().begin() + errorCount, parser.errors().end());
+        item.generation = generation;
+        fresh.push_back(std::move(item));
+        if (parser.aborted()) break;
+
+        uint64_t pos = parser.currentOffset();
+        while (next < items_.size() && shifted(items_[next].begin, delta) < pos) next++;
+        if (next < items_.size() && shifted(items_[next].begin, delta) == pos) {
+            synced = true;
+            break;
+        }
+    }
+
+    // Lexer errors: old ones before start, new ones up to the point where
+    // the parse rejoined the old items, and the old ones after it.
+    std::vector<LexerError> lexerErrors;
+    auto oldBefore = std::partition_point(lexerErrors_.begin(), lexerErrors_.end(),
+        [&](const LexerError& err) { return err.loc.offset < start; });
+    lexerErrors.assign(std::make_move_iterator(lexerErrors_.begin()),
+                       std::make_move_iterator(oldBefore));
+    uint64_t newEnd = synced ? parser.currentOffset() : UINT64_MAX;
+    for (const LexerError& err : lexer.errors()) {
+        if (err.loc.offset < newEnd) lexerErrors.push_back(err);
+    }
+    if (synced) {
+        uint64_t oldEnd = items_[next].begin;
+        auto oldAfter = std::partition_point(oldBefore, lexerErrors_.end(),
+            [&](const LexerError& err) { return err.loc.offset < oldEnd; });
+        for (auto it = oldAfter; it != lexerErrors_.end(); ++it) {
+            lexerErrors.push_back({std::move(it->message), {shifted(it->loc.offset, delta)}});
+        }
+    }
+    lexerErrors_.swap(lexerErrors);
+
+    adoptNodes(*generation, fresh, start, lexer);
+
+    size_t reuse = synced ? next : items_.size();
+    if (delta != 0) {
+        for (size_t i = reuse; i < items_.size(); ++i) shiftItem(items_[i], delta);
+    }
+    items_.erase(items_.begin() + keep, items_.begin() + reuse);
+    items_.insert(items_.begin() + keep, std::make_move_iterator(fresh.begin()),
+                  std::make_move_iterator(fresh.end()));
+
+    eofOffset_ = synced ? shifted(eofOffset_, delta) : parser.currentOffset();
+    aborted_ = parser.aborted() || (synced && aborted_);
+    rebuildTree();
+}
+
+void IncrementalParser::adoptNodes(Generation& generation, std::vector<Item>& fresh,
+                                   uint64_t start, const Lexer& lexer) {
+    // New nodes view text_, which the next edit changes, and the lexer's
+    // arena: copy the bytes they reference into the generation.
+    std::less<const char*> before;
+    const char* base = text_.data();
+    const char* limit = base + text_.size();
+    auto inText = [&](const char* p) { return !before(p, base) && before(p, limit); };
+
+    uint64_t textEnd = start;
+    for (const Item& item : fresh) {
+        forEachNode(item.node, [&](ASTNode& node) {
+            if (!node.value.empty() && inText(node.value.data())) {
+                textEnd = std::max<uint64_t>(textEnd, node.value.data() - base + node.value.size());
+            }
+            if (node.literal.kind == LiteralKind::LIT_STRING && node.literal.size > 0 &&
+                inText(node.literal.data)) {
+                textEnd = std::max<uint64_t>(textEnd, node.literal.data - base + node.literal.size);
+            }
+        });
+    }
+    generation.text.assign(text_, start, textEnd - start);
+    auto rebase = [&](const char* p) {
+        return generation.text.data() + (static_cast<uint64_t>(p - base) - start);
+    };
+
+    const SymbolTable& lexed = lexer.symbols();
+    std::vector<SymbolId> remap(lexed.size(), NO_SYMBOL);
+    auto resolve = [&](SymbolId id) {
+        if (remap[id] == NO_SYMBOL) {
+            std::string_view name = lexed.name(id);
+            SymbolId found = symbols_.find(name);
+            if (found == NO_SYMBOL) {
+                char* copy = static_cast<char*>(names_.allocate(name.size(), 1));
+                std::memcpy(copy, name.data(), name.size());
+                found = symbols_.intern(std::string_view(copy, name.size()));
+            }
+            remap[id] = found;
+        }
+        return remap[id];
+    };
+
+    for (const Item& item : fresh) {
+        forEachNode(item.node, [&](ASTNode& node) {
+            if (node.symbol != NO_SYMBOL) node.symbol = resolve(node.symbol);
+            if (!node.value.empty() && inText(node.value.data())) {
+                node.value = std::string_view(rebase(node.value.data()), node.value.size());
+            }
+            if (node.literal.kind == LiteralKind::LIT_STRING && node.literal.size > 0) {
+                if (inText(node.literal.data)) {
+                    node.literal.data = rebase(node.literal.data);
+                } else {
+                    char* copy = static_cast<char*>(generation.strings.allocate(node.literal.size, 1));
+                    std::memcpy(copy, node.literal.data, node.literal.size);
+                    node.literal.data = copy;
+                }
+            }
+        });
+    }
+}
+
+void IncrementalParser::shiftItem(Item& item, int64_t delta) {
+    item.begin = shifted(item.begin, delta);
+    item.end = shifted(item.end, delta);
+    if (item.dependsUntil != UINT64_MAX) item.dependsUntil = shifted(item.dependsUntil, delta);
+    for (ParseError& err : item.errors) err.loc.offset = shifted(err.loc.offset, delta);
+    item.pendingShift += delta;
+}
+
+ASTNodePtr IncrementalParser::tree() {
+    for (Item& item : items_) {
+        if (item.pendingShift == 0) continue;
+        int64_t delta = item.pendingShift;
+        forEachNode(item.node, [&](ASTNode& node) { node.loc.offset = shifted(node.loc.offset, delta); });
+        item.pendingShift = 0;
+    }
+    return root_;
+}
+
+void IncrementalParser::rebuildTree() {
+    // As in a full parse, the root sits at the first token.
+    root_->loc = {items_.empty() ? eofOffset_ : items_.front().begin};
+    root_->children.clear();
+    for (const Item& item : items_) {
+        if (item.node) root_->addChild(item.node);
+    }
+}
+
+std::vector<ParseError> IncrementalParser::errors() const {
+    std::vector<ParseError> all;
+    for (const Item& item : items_) {
+        all.insert(all.end(), item.errors.begin(), item.errors.end());
+    }
+    return all;
+}
+
+const LineIndex& IncrementalParser::lines() const {
+    if (!lines_) lines_ = std::make_unique<LineIndex>(text_);
+    return *lines_;
+}
@@ -1,73 +1,228 @@
 #include "../include/json_export.h"
+#include "../include/parallel_export.h"
 #include <sstream>
+#include <vector>
 
-std::string JsonExporter::escape(const std::string& s) {
-    std::string result;
-    result.reserve(s.size());
-    for (char c : s) {
-        switch (c) {
-            case '"':  result += "\\\""; break;
-            case '\\': result += "\\\\"; break;
-            case '\n': result += "\\n"; break;
-            case '\t': result += "\\t"; break;
-            case '\r': result += "\\r"; break;
-            default:   result += c; break;
-        }
+namespace {
+
+constexpr EscapeTable JSON_ESCAPES = makeEscapeTable({
+    {'"', "\\\""}, {'\\', "\\\\"}, {'\n', "\\n"}, {'\t', "\\t"}, {'\r', "\\r"},
+});
+
+} // namespace
+
+void JsonExporter::writeIndent(OutputBuffer& out, int indent) {
+    static const std::string_view SPACES = "                                                                ";
+    size_t count = static_cast<size_t>(indent) * 2;
+    while (count > SPACES.size()) {
+        out.write(SPACES);
+        count -= SPACES.size();
     }
-    return result;
+    out.write(SPACES.substr(0, count));
 }
 
-void JsonExporter::writeIndent(std::ostream& out, int indent) {
-    for (int i = 0; i < indent; ++i) out << "  ";
-}
+// Writes everything up to the children list: the opening brace, kind,
+// value and loc.
+void JsonExporter::writeNodeHead(OutputBuffer& out, const char* kind, std::string_view text,
+                                 LineColumn pos, int indent, bool compact) {
+    if (compact) {
+        out << "{\"kind\":\"" << kind << '"';
+        if (!text.empty()) {
+            out << ",\"value\":\"";
+            out.writeEscaped(text, JSON_ESCAPES);
+            out << '"';
+        }
+        out << ",\"loc\":{\"line\":" << pos.line << ",\"col\":" << pos.column << '}';
+        return;
+    }
 
-void JsonExporter::visitNode(const ASTNode* node, std::ostream& out, int indent) {
     writeIndent(out, indent);
     out << "{\n";
 
     writeIndent(out, indent + 1);
-    out << "\"kind\": \"" << node->kindStr() << "\"";
+    out << "\"kind\": \"" << kind << "\"";
 
-    if (!node->value.empty()) {
+    if (!text.empty()) {
         out << ",\n";
         writeIndent(out, indent + 1);
-        out << "\"value\": \"" << escape(node->value) << "\"";
+        out << "\"value\": \"";
+        out.writeEscaped(text, JSON_ESCAPES);
+        out << "\"";
     }
 
     out << ",\n";
     writeIndent(out, indent + 1);
-    out << "\"loc\": {\"line\": " << node->loc.line
-        << ", \"col\": " << node->loc.column << "}";
+    out << "\"loc\": {\"line\": " << pos.line
+        << ", \"col\": " << pos.column << "}";
+}
 
-    if (!node->children.empty()) {
-        out << ",\n";
-        writeIndent(out, indent + 1);
-        out << "\"children\": [\n";
-        for (size_t i = 0; i < node->children.size(); ++i) {
-            if (node->children[i]) {
-                visitNode(node->children[i].get(), out, indent + 2);
-            }
-            if (i + 1 < node->children.size()) out << ",";
-            out << "\n";
+void JsonExporter::writeChildrenOpen(OutputBuffer& out, int indent, bool compact) {
+    if (compact) {
+        out << ",\"children\":[";
+        return;
+    }
+    out << ",\n";
+    writeIndent(out, indent + 1);
+    out << "\"children\": [\n";
+}
+
+void JsonExporter::writeChildrenClose(OutputBuffer& out, int indent, bool compact) {
+    if (!compact) writeIndent(out, indent + 1);
+    out << "]";
+}
+
+void JsonExporter::writeNodeClose(OutputBuffer& out, int indent, bool compact) {
+    if (!compact) {
+        out << "\n";
+        writeIndent(out, indent);
+    }
+    out << "}";
+}
+
+// Walks the tree with an explicit stack of nodes whose children list is
+// open, so nesting depth is bounded by memory rather than the call stack.
+void JsonExporter::writeSubtree(OutputBuffer& out, const ASTNode* root, int rootIndent,
+                                const LineIndex& lines, const SymbolTable& symbols,
+                                bool compact) {
+    struct Frame {
+        const ASTNode* node;
+        size_t nextChild;
+        int indent;
+    };
+    std::vector<Frame> open;
+
+    // Writes node; returns true when its children list was opened.
+    auto writeNode = [&](const ASTNode* node, int indent) {
+        writeNodeHead(out, node->kindStr(), node->text(symbols),
+                      lines.resolve(node->loc.offset), indent, compact);
+        if (node->children.empty()) {
+            writeNodeClose(out, indent, compact);
+            return false;
         }
-        writeIndent(out, indent + 1);
-        out << "]";
+        writeChildrenOpen(out, indent, compact);
+        open.push_back({node, 0, indent});
+        return true;
+    };
+
+    writeNode(root, rootIndent);
+    while (!open.empty()) {
+        Frame& top = open.back();
+        const auto& children = top.node->children;
+        if (top.nextChild == children.size()) {
+            int indent = top.indent;
+            open.pop_back();
+            writeChildrenClose(out, indent, compact);
+            writeNodeClose(out, indent, compact);
+        } else {
+            const ASTNode* child = children[top.nextChild];
+            if (child && writeNode(child, top.indent + 2)) continue;
+        }
+        if (open.empty()) break;
+
+        // The current child of the top frame is finished.
+        Frame& parent = open.back();
+        if (++parent.nextChild < parent.node->children.size()) out << ',';
+        if (!compact) out << '\n';
     }
+}
 
+void JsonExporter::exportTree(const ASTNode* root, const LineIndex& lines,
+                              const SymbolTable& symbols, OutputBuffer& out, JsonStyle style) {
+    if (!root) return;
+    writeSubtree(out, root, 0, lines, symbols, style == JsonStyle::COMPACT);
     out << "\n";
-    writeIndent(out, indent);
-    out << "}";
 }
 
-void JsonExporter::exportTree(const ASTNode* root, std::ostream& out) {
-    if (root) {
-        visitNode(root, out, 0);
-        out << "\n";
+// The root's head and tail are written here; each item is a subtree at
+// the second indent level followed by its separator.
+void JsonExporter::exportTree(const ASTNode* root, const LineIndex& lines,
+                              const SymbolTable& symbols, OutputBuffer& out, ThreadPool& pool,
+                              JsonStyle style) {
+    if (!root || root->children.empty() || pool.size() <= 1) {
+        exportTree(root, lines, symbols, out, style);
+        return;
     }
+    bool compact = style == JsonStyle::COMPACT;
+    writeNodeHead(out, root->kindStr(), root->text(symbols), lines.resolve(root->loc.offset), 0,
+                  compact);
+    writeChildrenOpen(out, 0, compact);
+    renderItemsParallel(root, pool, out,
+        [&](OutputBuffer& chunk, size_t first, size_t last, uint64_t) {
+            const auto& items = root->children;
+            for (size_t i = first; i < last; ++i) {
+                if (items[i]) writeSubtree(chunk, items[i], 2, lines, symbols, compact);
+                if (i + 1 < items.size()) chunk << ',';
+                if (!compact) chunk << '\n';
+            }
+        });
+    writeChildrenClose(out, 0, compact);
+    writeNodeClose(out, 0, compact);
+    out << "\n";
+}
+
+void JsonExporter::exportTree(const ASTNode* root, const LineIndex& lines,
+                              const SymbolTable& symbols, std::ostream& out, JsonStyle style) {
+    OutputBuffer buffer(out);
+    exportTree(root, lines, symbols, buffer, style);
+    buffer.flush();
+}
+
+std::string JsonExporter::exportTree(const ASTNode* root, const LineIndex& lines,
+                                     const SymbolTable& symbols, JsonStyle style) {
+    std::ostringstream oss;
+    exportTree(root, lines, symbols, oss, style);
+    return oss.str();
+}
+
+// Linear walk over the flat layout. open holds the ancestors whose
+// children list is being written; a node's depth is its indent / 2.
+void JsonExporter::exportTree(const FlatAst& ast, const LineIndex& lines,
+                              const SymbolTable& symbols, OutputBuffer& out, JsonStyle style) {
+    if (ast.empty()) return;
+    bool compact = style == JsonStyle::COMPACT;
+
+    std::vector<uint32_t> open;
+    for (uint32_t i = 0; i < ast.size(); ++i) {
+        int indent = static_cast<int>(open.size()) * 2;
+        writeNodeHead(out, ASTNode::kindName(ast.kind(i)), ast.text(i, symbols),
+                      lines.resolve(ast.loc(i).offset), indent, compact);
+        if (ast.hasChildren(i)) {
+            writeChildrenOpen(out, indent, compact);
+            open.push_back(i);
+            continue;
+        }
+        writeNodeClose(out, indent, compact);
+
+        // Close every ancestor whose last child this was.
+        uint32_t last = i;
+        while (!open.empty()) {
+            uint32_t parent = open.back();
+            if (ast.end(last) < ast.end(parent)) {
+                out << ',';
+                if (!compact) out << '\n';
+                break;
+            }
+            if (!compact) out << '\n';
+            open.pop_back();
+            int parentIndent = static_cast<int>(open.size()) * 2;
+            writeChildrenClose(out, parentIndent, compact);
+            writeNodeClose(out, parentIndent, compact);
+            last = parent;
+        }
+    }
+    out << "\n";
+}
+
+void JsonExporter::exportTree(const FlatAst& ast, const LineIndex& lines,
+                              const SymbolTable& symbols, std::ostream& out, JsonStyle style) {
+    OutputBuffer buffer(out);
+    exportTree(ast, lines, symbols, buffer, style);
+    buffer.flush();
 }
 
-std::string JsonExporter::exportTree(const ASTNode* root) {
+std::string JsonExporter::exportTree(const FlatAst& ast, const LineIndex& lines,
+                                     const SymbolTable& symbols, JsonStyle style) {
     std::ostringstream oss;
-    exportTree(root, oss);
+    exportTree(ast, lines, symbols, oss, style);
     return oss.str();
 }
@@ -1,9 +1,118 @@
 #include "../include/lexer.h"
+#include <algorithm>
 #include <cctype>
-#include <unordered_map>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+// --- Operator tables ----------------------------------------------------------
+//
+// Every operator and punctuation token is listed once in OPERATORS. The
+// 256-entry CHAR_TABLE and the two-character OPERATOR_PAIRS list are
+// derived from it at compile time, so next() dispatches on the first byte
+// with one table load and checks at most two candidate second bytes.
+
+namespace {
+
+struct OperatorSpec {
+    const char* spelling;
+    TokenType type;
+};
+
+constexpr OperatorSpec OPERATORS[] = {
+    {"==", TokenType::TOK_EQ},     {"!=", TokenType::TOK_NE},
+    {"<=", TokenType::TOK_LE},     {">=", TokenType::TOK_GE},
+    {"<<", TokenType::TOK_SHL},    {">>", TokenType::TOK_SHR},
+    {"&&", TokenType::TOK_AND},    {"||", TokenType::TOK_OR},
+    {"++", TokenType::TOK_INC},    {"--", TokenType::TOK_DEC_OP},
+    {"..", TokenType::TOK_DOTDOT},
+
+    {"+", TokenType::TOK_PLUS},    {"-", TokenType::TOK_MINUS},
+    {"*", TokenType::TOK_STAR},    {"/", TokenType::TOK_SLASH},
+    {"%", TokenType::TOK_PERCENT}, {"&", TokenType::TOK_AMP},
+    {"|", TokenType::TOK_PIPE},    {"^", TokenType::TOK_CARET},
+    {"~", TokenType::TOK_TILDE},   {"!", TokenType::TOK_BANG},
+    {"<", TokenType::TOK_LT},      {">", TokenType::TOK_GT},
+    {"=", TokenType::TOK_ASSIGN},
+    {"(", TokenType::TOK_LPAREN},  {")", TokenType::TOK_RPAREN},
+    {"[", TokenType::TOK_LBRACKET}, {"]", TokenType::TOK_RBRACKET},
+    {"{", TokenType::TOK_LBRACE},  {"}", TokenType::TOK_RBRACE},
+    {",", TokenType::TOK_COMMA},   {";", TokenType::TOK_SEMICOLON},
+};
+
+constexpr size_t countPairs() {
+    size_t count = 0;
+    for (const OperatorSpec& op : OPERATORS) {
+        if (op.spelling[1] != '\0') ++count;
+    }
+    return count;
+}
+
+enum class CharClass : uint8_t { Other, Quote, Apostrophe, Digit, IdentStart, Operator };
+
+struct CharInfo {
+    CharClass cls;
+    TokenType single;       // one-character operator, TOK_ERROR if none
+    uint8_t pairStart;      // slice of OPERATOR_PAIRS starting with this byte
+    uint8_t pairCount;
+};
+
+struct OperatorPair {
+    char second;
+    TokenType type;
+};
+
+constexpr size_t PAIR_COUNT = countPairs();
+
+struct OperatorTables {
+    CharInfo chars[256];
+    OperatorPair pairs[PAIR_COUNT];
+};
+
+constexpr OperatorTables buildOperatorTables() {
+    OperatorTables t{};
+    for (int c = 0; c < 256; ++c) {
+        CharClass cls = CharClass::Other;
+        if (c == '"') cls = CharClass::Quote;
+        else if (c == '\'') cls = CharClass::Apostrophe;
+        else if (c >= '0' && c <= '9') cls = CharClass::Digit;
+        else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_') cls = CharClass::IdentStart;
+        t.chars[c] = CharInfo{cls, TokenType::TOK_ERROR, 0, 0};
+    }
+
+    // Pairs are grouped by first byte so each byte owns a contiguous slice.
+    uint8_t next = 0;
+    for (int c = 0; c < 256; ++c) {
+        t.chars[c].pairStart = next;
+        for (const OperatorSpec& op : OPERATORS) {
+            if (static_cast<unsigned char>(op.spelling[0]) != c) continue;
+            t.chars[c].cls = CharClass::Operator;
+            if (op.spelling[1] == '\0') {
+                t.chars[c].single = op.type;
+            } else {
+                t.pairs[next++] = OperatorPair{op.spelling[1], op.type};
+                t.chars[c].pairCount++;
+            }
+        }
+    }
+    return t;
+}
+
+constexpr OperatorTables OPERATOR_TABLES = buildOperatorTables();
+constexpr const CharInfo (&CHAR_TABLE)[256] = OPERATOR_TABLES.chars;
+constexpr const OperatorPair (&OPERATOR_PAIRS)[PAIR_COUNT] = OPERATOR_TABLES.pairs;
+
+} // namespace
 
 Lexer::Lexer(const std::string& source)
-    : source_(source), pos_(0), line_(1), col_(1) {}
+    : Lexer(SourceBuffer(source)) {}
+
+Lexer::Lexer(SourceBuffer source)
+    : buffer_(std::move(source)), source_(buffer_.view()), scan_(selectScanKernels()),
+      pos_(0) {}
+
+Lexer::Lexer(std::string_view source, uint64_t start)
+    : source_(source), scan_(selectScanKernels()), pos_(start) {}
 
 char Lexer::peek() const {
     if (isAtEnd()) return '\0';
@@ -16,15 +125,23 @@ char Lexer::peekNext() const {
 }
 
 char Lexer::advance() {
-    char c = source_[pos_];
-    pos_++;
-    if (c == '\n') {
-        line_++;
-        col_ = 1;
-    } else {
-        col_++;
-    }
-    return c;
+    return source_[pos_++];
+}
+
+void Lexer::restart(uint64_t offset) {
+    reportedUntil_ = std::max<uint64_t>(reportedUntil_, pos_);
+    pos_ = offset;
+}
+
+void Lexer::error(const std::string& msg, SourceLocation loc) {
+    // Tokens lexed again after restart() were reported the first time.
+    if (loc.offset < reportedUntil_) return;
+    errors_.push_back({msg, loc});
+}
+
+const LineIndex& Lexer::lines() const {
+    if (!lines_) lines_ = std::make_unique<LineIndex>(source_);
+    return *lines_;
 }
 
 bool Lexer::isAtEnd() const {
@@ -32,17 +149,21 @@ bool Lexer::isAtEnd() const {
 }
 
 void Lexer::skipWhitespaceAndComments() {
+    const char* end = source_.data() + source_.size();
     for (;;) {
         if (isAtEnd()) return;
         char c = peek();
         if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
-            advance();
+            pos_ += scan_.whitespace(source_.data() + pos_, end);
         } else if (c == '/' && peekNext() == '/') {
-            while (!isAtEnd() && peek() != '\n') advance();
+            pos_ += scan_.untilNewline(source_.data() + pos_, end);
         } else if (c == '/' && peekNext() == '*') {
             advance(); advance();
             int depth = 1;
             while (!isAtEnd() && depth > 0) {
+                // Only '/' and '*' can open or close a comment.
+                pos_ += scan_.blockComment(source_.data() + pos_, end);
+                if (isAtEnd()) break;
                 if (peek() == '/' && peekNext() == '*') {
                     advance(); advance();
                     depth++;
@@ -59,173 +180,254 @@ void Lexer::skipWhitespaceAndComments() {
     }
 }
 
-Token Lexer::makeToken(TokenType type, const std::string& text, SourceLocation loc) {
-    return Token{type, text, loc};
+Token Lexer::makeToken(TokenType type, size_t start, SourceLocation loc) const {
+    return Token{type, NO_SYMBOL, source_.substr(start, pos_ - start), loc, {}};
+}
+
+// Resolves escapes in a string literal body. Unknown escapes stand for
+// the escaped character itself.
+std::string_view Lexer::unescape(std::string_view body) {
+    char* out = static_cast<char*>(strings_.allocate(body.size(), 1));
+    size_t len = 0;
+    for (size_t i = 0; i < body.size(); ++i) {
+        char c = body[i];
+        if (c == '\\' && i + 1 < body.size()) {
+            switch (body[++i]) {
+                case 'n': c = '\n'; break;
+                case 't': c = '\t'; break;
+                case 'r': c = '\r'; break;
+                case '0': c = '\0'; break;
+                default:  c = body[i]; break;
+            }
+        }
+        out[len++] = c;
+    }
+    return std::string_view(out, len);
 }
 
 Token Lexer::readString() {
-    SourceLocation loc{line_, col_, static_cast<int>(pos_)};
+    SourceLocation loc{pos_};
+    size_t start = pos_;
+    const char* end = source_.data() + source_.size();
+    bool escaped = false;
     advance();
-    std::string val = "\"";
-    while (!isAtEnd() && peek() != '"') {
-        if (peek() == '\\') {
-            val += advance();
-            if (!isAtEnd()) val += advance();
-        } else {
-            val += advance();
-        }
+    for (;;) {
+        pos_ += scan_.stringBody(source_.data() + pos_, end);
+        if (isAtEnd() || peek() == '"') break;
+        advance(); // '\\'
+        escaped = true;
+        if (!isAtEnd()) advance();
     }
     if (!isAtEnd()) {
-        val += advance();
+        advance();
     } else {
-        errors_.push_back({"Unterminated string literal", loc});
-        return makeToken(TokenType::TOK_ERROR, val, loc);
+        error("Unterminated string literal", loc);
+        return makeToken(TokenType::TOK_ERROR, start, loc);
+    }
+    Token tok = makeToken(TokenType::TOK_STRING, start, loc);
+    std::string_view body = tok.text.substr(1, tok.text.size() - 2);
+    if (body.size() > UINT32_MAX) {
+        error("String literal too long", loc);
+        return tok;
     }
-    return makeToken(TokenType::TOK_STRING, val, loc);
+    if (escaped) body = unescape(body);
+    tok.literal.kind = LiteralKind::LIT_STRING;
+    tok.literal.size = static_cast<uint32_t>(body.size());
+    tok.literal.data = body.data();
+    return tok;
 }
 
 Token Lexer::readChar() {
-    SourceLocation loc{line_, col_, static_cast<int>(pos_)};
-    std::string val;
-    val += advance(); // '
+    SourceLocation loc{pos_};
+    size_t start = pos_;
+    advance(); // '
     if (!isAtEnd() && peek() != '\'') {
-        val += advance();
+        advance();
     }
     if (!isAtEnd() && peek() == '\'') {
-        val += advance();
+        advance();
     } else {
-        errors_.push_back({"Unterminated char literal", loc});
-        return makeToken(TokenType::TOK_ERROR, val, loc);
+        error("Unterminated char literal", loc);
+        return makeToken(TokenType::TOK_ERROR, start, loc);
     }
-    return makeToken(TokenType::TOK_CHAR, val, loc);
+    Token tok = makeToken(TokenType::TOK_CHAR, start, loc);
+    tok.literal.kind = LiteralKind::LIT_CHAR;
+    // '' has no character and decodes to 0.
+    if (tok.text.size() == 3) tok.literal.integer = static_cast<unsigned char>(tok.text[1]);
+    return tok;
+}
+
+// Fills tok.literal from the digits in tok.text starting at digitsStart
+// (relative to the token). Values above UINT64_MAX are reported.
+void Lexer::decodeInteger(Token& tok, size_t digitsStart, unsigned base) {
+    const uint64_t limit = UINT64_MAX / base;
+    uint64_t value = 0;
+    bool overflow = false;
+    for (size_t i = digitsStart; i < tok.text.size(); ++i) {
+        char c = tok.text[i];
+        unsigned digit = c <= '9' ? static_cast<unsigned>(c - '0')
+                                  : static_cast<unsigned>((c | 0x20) - 'a' + 10);
+        if (value > limit || value * base > UINT64_MAX - digit) {
+            overflow = true;
+            break;
+        }
+        value = value * base + digit;
+    }
+    if (overflow) {
+        error("Integer literal out of range: " + std::string(tok.text), tok.loc);
+        value = 0;
+    }
+    tok.literal.kind = LiteralKind::LIT_INT;
+    tok.literal.integer = value;
 }
 
 Token Lexer::readNumber() {
-    SourceLocation loc{line_, col_, static_cast<int>(pos_)};
-    std::string val;
+    SourceLocation loc{pos_};
+    size_t start = pos_;
 
     if (peek() == '0' && (peekNext() == 'x' || peekNext() == 'X')) {
-        val += advance(); // 0
-        val += advance(); // x
+        advance(); // 0
+        advance(); // x
         while (!isAtEnd() && std::isxdigit(static_cast<unsigned char>(peek()))) {
-            val += advance();
+            advance();
         }
-        return makeToken(TokenType::TOK_HEX, val, loc);
+        Token tok = makeToken(TokenType::TOK_HEX, start, loc);
+        decodeInteger(tok, 2, 16);
+        return tok;
     }
 
     if (peek() == '0' && (peekNext() == 'b' || peekNext() == 'B')) {
-        val += advance(); // 0
-        val += advance(); // b
+        advance(); // 0
+        advance(); // b
         while (!isAtEnd() && (peek() == '0' || peek() == '1')) {
-            val += advance();
+            advance();
         }
-        return makeToken(TokenType::TOK_BITS, val, loc);
-    }
-
-    while (!isAtEnd() && std::isdigit(static_cast<unsigned char>(peek()))) {
-        val += advance();
-    }
-    return makeToken(TokenType::TOK_DEC, val, loc);
-}
-
-TokenType Lexer::keywordType(const std::string& word) {
-    static const std::unordered_map<std::string, TokenType> keywords = {
-        {"def",    TokenType::TOK_DEF},
-        {"end",    TokenType::TOK_END},
-        {"if",     TokenType::TOK_IF},
-        {"then",   TokenType::TOK_THEN},
-        {"else",   TokenType::TOK_ELSE},
-        {"while",  TokenType::TOK_WHILE},
-        {"until",  TokenType::TOK_UNTIL},
-        {"break",  TokenType::TOK_BREAK},
-        {"begin",  TokenType::TOK_BEGIN},
-        {"of",     TokenType::TOK_OF},
-        {"bool",   TokenType::TOK_BOOL},
-        {"byte",   TokenType::TOK_BYTE},
-        {"int",    TokenType::TOK_INT},
-        {"uint",   TokenType::TOK_UINT},
-        {"long",   TokenType::TOK_LONG},
-        {"ulong",  TokenType::TOK_ULONG},
-        {"char",   TokenType::TOK_CHARTYPE},
-        {"string", TokenType::TOK_STRINGTYPE},
-        {"array",  TokenType::TOK_ARRAY},
-        {"true",   TokenType::TOK_TRUE},
-        {"false",  TokenType::TOK_FALSE},
+        Token tok = makeToken(TokenType::TOK_BITS, start, loc);
+        decodeInteger(tok, 2, 2);
+        return tok;
+    }
+
+    pos_ += scan_.digits(source_.data() + pos_, source_.data() + source_.size());
+    Token tok = makeToken(TokenType::TOK_DEC, start, loc);
+    decodeInteger(tok, 0, 10);
+    return tok;
+}
+
+// Keywords are told apart by length and first character, so an
+// identifier costs at most one switch and one short memcmp.
+TokenType Lexer::keywordType(std::string_view word) {
+    auto is = [&word](const char* keyword) {
+        return std::memcmp(word.data(), keyword, word.size()) == 0;
     };
-    auto it = keywords.find(word);
-    if (it != keywords.end()) return it->second;
+
+    switch (word.size()) {
+        case 2:
+            switch (word[0]) {
+                case 'i': if (is("if")) return TokenType::TOK_IF; break;
+                case 'o': if (is("of")) return TokenType::TOK_OF; break;
+            }
+            break;
+        case 3:
+            switch (word[0]) {
+                case 'd': if (is("def")) return TokenType::TOK_DEF; break;
+                case 'e': if (is("end")) return TokenType::TOK_END; break;
+                case 'i': if (is("int")) return TokenType::TOK_INT; break;
+            }
+            break;
+        case 4:
+            switch (word[0]) {
+                case 'b':
+                    if (is("bool")) return TokenType::TOK_BOOL;
+                    if (is("byte")) return TokenType::TOK_BYTE;
+                    break;
+                case 'c': if (is("char")) return TokenType::TOK_CHARTYPE; break;
+                case 'e': if (is("else")) return TokenType::TOK_ELSE; break;
+                case 'l': if (is("long")) return TokenType::TOK_LONG; break;
+                case 't':
+                    if (is("then")) return TokenType::TOK_THEN;
+                    if (is("true")) return TokenType::TOK_TRUE;
+                    break;
+                case 'u': if (is("uint")) return TokenType::TOK_UINT; break;
+            }
+            break;
+        case 5:
+            switch (word[0]) {
+                case 'a': if (is("array")) return TokenType::TOK_ARRAY; break;
+                case 'b':
+                    if (is("break")) return TokenType::TOK_BREAK;
+                    if (is("begin")) return TokenType::TOK_BEGIN;
+                    break;
+                case 'f': if (is("false")) return TokenType::TOK_FALSE; break;
+                case 'u':
+                    if (is("until")) return TokenType::TOK_UNTIL;
+                    if (is("ulong")) return TokenType::TOK_ULONG;
+                    break;
+                case 'w': if (is("while")) return TokenType::TOK_WHILE; break;
+            }
+            break;
+        case 6:
+            if (is("string")) return TokenType::TOK_STRINGTYPE;
+            break;
+    }
     return TokenType::TOK_IDENT;
 }
 
 Token Lexer::readIdentOrKeyword() {
-    SourceLocation loc{line_, col_, static_cast<int>(pos_)};
-    std::string val;
-    while (!isAtEnd() && (std::isalnum(static_cast<unsigned char>(peek())) || peek() == '_')) {
-        val += advance();
+    SourceLocation loc{pos_};
+    size_t start = pos_;
+    pos_ += scan_.identChars(source_.data() + pos_, source_.data() + source_.size());
+    Token tok = makeToken(TokenType::TOK_IDENT, start, loc);
+    tok.type = keywordType(tok.text);
+    if (tok.type == TokenType::TOK_IDENT) tok.symbol = symbols_.intern(tok.text);
+    if (tok.type == TokenType::TOK_TRUE || tok.type == TokenType::TOK_FALSE) {
+        tok.literal.kind = LiteralKind::LIT_BOOL;
+        tok.literal.integer = tok.type == TokenType::TOK_TRUE;
     }
-    return makeToken(keywordType(val), val, loc);
+    return tok;
 }
 
-std::vector<Token> Lexer::tokenize() {
-    std::vector<Token> tokens;
-    tokens.reserve(source_.size() / 4);
+Token Lexer::next() {
+    skipWhitespaceAndComments();
+    if (isAtEnd()) {
+        return makeToken(TokenType::TOK_EOF, pos_, {pos_});
+    }
 
-    for (;;) {
-        skipWhitespaceAndComments();
-        if (isAtEnd()) {
-            tokens.push_back(makeToken(TokenType::TOK_EOF, "", {line_, col_, static_cast<int>(pos_)}));
+    SourceLocation loc{pos_};
+    size_t start = pos_;
+    const CharInfo& info = CHAR_TABLE[static_cast<unsigned char>(peek())];
+
+    switch (info.cls) {
+        case CharClass::Quote: return readString();
+        case CharClass::Apostrophe: return readChar();
+        case CharClass::Digit: return readNumber();
+        case CharClass::IdentStart: return readIdentOrKeyword();
+        case CharClass::Operator: {
+            char n = peekNext();
+            for (uint8_t i = info.pairStart; i < info.pairStart + info.pairCount; ++i) {
+                if (OPERATOR_PAIRS[i].second == n) {
+                    pos_ += 2;
+                    return makeToken(OPERATOR_PAIRS[i].type, start, loc);
+                }
+            }
+            if (info.single != TokenType::TOK_ERROR) {
+                advance();
+                return makeToken(info.single, start, loc);
+            }
             break;
         }
+        case CharClass::Other:
+            break;
+    }
 
-        SourceLocation loc{line_, col_, static_cast<int>(pos_)};
-        char c = peek();
-
-        if (c == '"') { tokens.push_back(readString()); continue; }
-        if (c == '\'') { tokens.push_back(readChar()); continue; }
-        if (std::isdigit(static_cast<unsigned char>(c))) { tokens.push_back(readNumber()); continue; }
-        if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') { tokens.push_back(readIdentOrKeyword()); continue; }
-
-        char n = peekNext();
-        if (c == '=' && n == '=') { advance(); advance(); tokens.push_back(makeToken(TokenType::TOK_EQ, "==", loc)); continue; }
-        if (c == '!' && n == '=') { advance(); advance(); tokens.push_back(makeToken(TokenType::TOK_NE, "!=", loc)); continue; }
-        if (c == '<' && n == '=') { advance(); advance(); tokens.push_back(makeToken(TokenType::TOK_LE, "<=", loc)); continue; }
-        if (c == '>' && n == '=') { advance(); advance(); tokens.push_back(makeToken(TokenType::TOK_GE, ">=", loc)); continue; }
-        if (c == '<' && n == '<') { advance(); advance(); tokens.push_back(makeToken(TokenType::TOK_SHL, "<<", loc)); continue; }
-        if (c == '>' && n == '>') { advance(); advance(); tokens.push_back(makeToken(TokenType::TOK_SHR, ">>", loc)); continue; }
-        if (c == '&' && n == '&') { advance(); advance(); tokens.push_back(makeToken(TokenType::TOK_AND, "&&", loc)); continue; }
-        if (c == '|' && n == '|') { advance(); advance(); tokens.push_back(makeToken(TokenType::TOK_OR, "||", loc)); continue; }
-        if (c == '+' && n == '+') { advance(); advance(); tokens.push_back(makeToken(TokenType::TOK_INC, "++", loc)); continue; }
-        if (c == '-' && n == '-') { advance(); advance(); tokens.push_back(makeToken(TokenType::TOK_DEC_OP, "--", loc)); continue; }
-        if (c == '.' && n == '.') { advance(); advance(); tokens.push_back(makeToken(TokenType::TOK_DOTDOT, "..", loc)); continue; }
+    char c = advance();
+    error("Unexpected character: " + std::string(1, c), loc);
+    return makeToken(TokenType::TOK_ERROR, start, loc);
+}
 
-        advance();
-        switch (c) {
-            case '+': tokens.push_back(makeToken(TokenType::TOK_PLUS, "+", loc)); break;
-            case '-': tokens.push_back(makeToken(TokenType::TOK_MINUS, "-", loc)); break;
-            case '*': tokens.push_back(makeToken(TokenType::TOK_STAR, "*", loc)); break;
-            case '/': tokens.push_back(makeToken(TokenType::TOK_SLASH, "/", loc)); break;
-            case '%': tokens.push_back(makeToken(TokenType::TOK_PERCENT, "%", loc)); break;
-            case '&': tokens.push_back(makeToken(TokenType::TOK_AMP, "&", loc)); break;
-            case '|': tokens.push_back(makeToken(TokenType::TOK_PIPE, "|", loc)); break;
-            case '^': tokens.push_back(makeToken(TokenType::TOK_CARET, "^", loc)); break;
-            case '~': tokens.push_back(makeToken(TokenType::TOK_TILDE, "~", loc)); break;
-            case '!': tokens.push_back(makeToken(TokenType::TOK_BANG, "!", loc)); break;
-            case '<': tokens.push_back(makeToken(TokenType::TOK_LT, "<", loc)); break;
-            case '>': tokens.push_back(makeToken(TokenType::TOK_GT, ">", loc)); break;
-            case '=': tokens.push_back(makeToken(TokenType::TOK_ASSIGN, "=", loc)); break;
-            case '(': tokens.push_back(makeToken(TokenType::TOK_LPAREN, "(", loc)); break;
-            case ')': tokens.push_back(makeToken(TokenType::TOK_RPAREN, ")", loc)); break;
-            case '[': tokens.push_back(makeToken(TokenType::TOK_LBRACKET, "[", loc)); break;
-            case ']': tokens.push_back(makeToken(TokenType::TOK_RBRACKET, "]", loc)); break;
-            case '{': tokens.push_back(makeToken(TokenType::TOK_LBRACE, "{", loc)); break;
-            case '}': tokens.push_back(makeToken(TokenType::TOK_RBRACE, "}", loc)); break;
-            case ',': tokens.push_back(makeToken(TokenType::TOK_COMMA, ",", loc)); break;
-            case ';': tokens.push_back(makeToken(TokenType::TOK_SEMICOLON, ";", loc)); break;
-            default:
-                errors_.push_back({"Unexpected character: " + std::string(1, c), loc});
-                tokens.push_back(makeToken(TokenType::TOK_ERROR, std::string(1, c), loc));
-                break;
-        }
-    }
+std::vector<Token> Lexer::tokenize() {
+    std::vector<Token> tokens;
+    do {
+        tokens.push_back(next());
+    } while (tokens.back().type != TokenType::TOK_EOF);
     return tokens;
 }
@@ -0,0 +1,124 @@
+#include "../include/lexer_scan.h"
+#include "lexer_scan_simd.h"
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LEXER_SCAN_X86 1
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <immintrin.h>
+#endif
+#endif
+
+// --- Scalar -----------------------------------------------------------------
+
+template <class IsStop>
+static size_t scalarRun(const char* p, const char* end, IsStop isStop) {
+    const char* start = p;
+    while (p < end && !isStop(*p)) ++p;
+    return static_cast<size_t>(p - start);
+}
+
+static size_t scalarWhitespace(const char* p, const char* end) {
+    return scalarRun(p, end, [](char c) { return !isWhitespaceByte(c); });
+}
+
+static size_t scalarIdentChars(const char* p, const char* end) {
+    return scalarRun(p, end, [](char c) { return !isIdentByte(c); });
+}
+
+static size_t scalarDigits(const char* p, const char* end) {
+    return scalarRun(p, end, [](char c) { return c < '0' || c > '9'; });
+}
+
+static size_t scalarUntilNewline(const char* p, const char* end) {
+    return scalarRun(p, end, [](char c) { return c == '\n'; });
+}
+
+static size_t scalarBlockComment(const char* p, const char* end) {
+    return scalarRun(p, end, [](char c) { return c == '/' || c == '*'; });
+}
+
+static size_t scalarStringBody(const char* p, const char* end) {
+    return scalarRun(p, end, [](char c) { return c == '"' || c == '\\'; });
+}
+
+const ScanKernels& scalarScanKernels() {
+    static const ScanKernels kernels{"scalar", scalarWhitespace, scalarIdentChars, scalarDigits,
+                                     scalarUntilNewline, scalarBlockComment, scalarStringBody};
+    return kernels;
+}
+
+// --- SSE2 -------------------------------------------------------------------
+
+#ifdef LEXER_SCAN_X86
+
+struct Sse2Block {
+    static constexpr size_t WIDTH = 16;
+    static constexpr uint32_t ALL = 0xFFFFu;
+
+    __m128i v;
+
+    static Sse2Block load(const char* p) {
+        return {_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))};
+    }
+    uint32_t eq(char c) const {
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c))));
+    }
+    // Signed compares: bytes >= 0x80 are negative and never in an ASCII range.
+    uint32_t inRange(char lo, char hi) const {
+        __m128i ge = _mm_cmpgt_epi8(v, _mm_set1_epi8(static_cast<char>(lo - 1)));
+        __m128i le = _mm_cmplt_epi8(v, _mm_set1_epi8(static_cast<char>(hi + 1)));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(ge, le)));
+    }
+};
+
+const ScanKernels* sse2ScanKernels() {
+    static const ScanKernels kernels = SimdScanner<Sse2Block>::kernels("sse2");
+    return &kernels;
+}
+
+#else
+
+const ScanKernels* sse2ScanKernels() {
+    return nullptr;
+}
+
+#endif
+
+// --- Dispatch ---------------------------------------------------------------
+
+static bool cpuHasAvx2() {
+#if defined(LEXER_SCAN_X86) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#elif defined(LEXER_SCAN_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return false;
+#endif
+}
+
+static const ScanKernels& pickScanKernels() {
+    const char* forced = std::getenv("PL_LAB1_SIMD");
+    bool allowAvx2 = !forced || std::strcmp(forced, "avx2") == 0;
+    bool allowSse2 = allowAvx2 || std::strcmp(forced, "sse2") == 0;
+
+    if (allowAvx2 && avx2ScanKernels() && cpuHasAvx2()) return *avx2ScanKernels();
+    if (allowSse2 && sse2ScanKernels()) return *sse2ScanKernels();
+    return scalarScanKernels();
+}
+
+const ScanKernels& selectScanKernels() {
+    static const ScanKernels& kernels = pickScanKernels();
+    return kernels;
+}
@@ -0,0 +1,56 @@
+// AVX2 scanner kernels. The whole translation unit is compiled for AVX2
+// so the shared kernel templates inline the 256-bit intrinsics; it is
+// only ever called after selectScanKernels() has checked the CPU.
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LEXER_SCAN_AVX2 1
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC target("avx2")
+#endif
+#include <immintrin.h>
+#endif
+
+#include "../include/lexer_scan.h"
+
+#ifdef LEXER_SCAN_AVX2
+
+#include "lexer_scan_simd.h"
+
+struct Avx2Block {
+    static constexpr size_t WIDTH = 32;
+    static constexpr uint32_t ALL = 0xFFFFFFFFu;
+
+    __m256i v;
+
+    static Avx2Block load(const char* p) {
+        return {_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))};
+    }
+    uint32_t eq(char c) const {
+        return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c))));
+    }
+    // Signed compares: bytes >= 0x80 are negative and never in an ASCII range.
+    uint32_t inRange(char lo, char hi) const {
+        __m256i ge = _mm256_cmpgt_epi8(v, _mm256_set1_epi8(static_cast<char>(lo - 1)));
+        __m256i le = _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(hi + 1)), v);
+        return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(ge, le)));
+    }
+};
+
+const ScanKernels* avx2ScanKernels() {
+    static const ScanKernels kernels = SimdScanner<Avx2Block>::kernels("avx2");
+    return &kernels;
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
+
+#else
+
+const ScanKernels* avx2ScanKernels() {
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef LEXER_SCAN_SIMD_H
+#define LEXER_SCAN_SIMD_H
+
+// Scanner kernels shared by the SSE2 and AVX2 implementations. Included
+// only from lexer_scan*.cpp; everything lives in an unnamed namespace so
+// each translation unit keeps its own copy compiled for its own target.
+//
+// A Block wraps one vector register and provides:
+//   WIDTH            bytes per block
+//   load(p)          unaligned load
+//   eq(c)            bit i set when byte i == c
+//   inRange(lo, hi)  bit i set when lo <= byte i <= hi (ASCII only)
+//   ALL              mask with all WIDTH bits set
+
+#include "../include/lexer_scan.h"
+#include <cstdint>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace {
+
+inline unsigned lowestBit(uint32_t x) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long idx;
+    _BitScanForward(&idx, x);
+    return idx;
+#else
+    return static_cast<unsigned>(__builtin_ctz(x));
+#endif
+}
+
+inline bool isWhitespaceByte(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+inline bool isIdentByte(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           (c >= '0' && c <= '9') || c == '_';
+}
+
+template <class Block>
+struct SimdScanner {
+    // Length of the run before the first byte selected by stopMask
+    // (block-wise) or isStop (byte-wise, for the tail).
+    template <class StopMask, class IsStop>
+    static size_t run(const char* p, const char* end, StopMask stopMask, IsStop isStop) {
+        const char* start = p;
+        while (static_cast<size_t>(end - p) >= Block::WIDTH) {
+            uint32_t stop = stopMask(Block::load(p));
+            if (stop) return static_cast<size_t>(p - start) + lowestBit(stop);
+            p += Block::WIDTH;
+        }
+        while (p < end && !isStop(*p)) ++p;
+        return static_cast<size_t>(p - start);
+    }
+
+    static size_t whitespace(const char* p, const char* end) {
+        return run(p, end,
+            [](const Block& b) {
+                return ~(b.eq(' ') | b.eq('\t') | b.eq('\r') | b.eq('\n')) & Block::ALL;
+            },
+            [](char c) { return !isWhitespaceByte(c); });
+    }
+
+    static size_t identChars(const char* p, const char* end) {
+        return run(p, end,
+            [](const Block& b) {
+                uint32_t ok = b.inRange('a', 'z') | b.inRange('A', 'Z') |
+                              b.inRange('0', '9') | b.eq('_');
+                return ~ok & Block::ALL;
+            },
+            [](char c) { return !isIdentByte(c); });
+    }
+
+    static size_t digits(const char* p, const char* end) {
+        return run(p, end,
+            [](const Block& b) { return ~b.inRange('0', '9') & Block::ALL; },
+            [](char c) { return c < '0' || c > '9'; });
+    }
+
+    static size_t untilNewline(const char* p, const char* end) {
+        return run(p, end,
+            [](const Block& b) { return b.eq('\n'); },
+            [](char c) { return c == '\n'; });
+    }
+
+    static size_t blockComment(const char* p, const char* end) {
+        return run(p, end,
+            [](const Block& b) { return b.eq('/') | b.eq('*'); },
+            [](char c) { return c == '/' || c == '*'; });
+    }
+
+    static size_t stringBody(const char* p, const char* end) {
+        return run(p, end,
+            [](const Block& b) { return b.eq('"') | b.eq('\\'); },
+            [](char c) { return c == '"' || c == '\\'; });
+    }
+
+    static ScanKernels kernels(const char* name) {
+        return ScanKernels{name, whitespace, identChars, digits,
+                           untilNewline, blockComment, stringBody};
+    }
+};
+
+} // namespace
+
+#endif
@@ -0,0 +1,23 @@
+#include "../include/line_index.h"
+#include "../include/lexer_scan.h"
+#include <algorithm>
+
+LineIndex::LineIndex(std::string_view source) {
+    const ScanKernels& scan = selectScanKernels();
+    const char* begin = source.data();
+    const char* end = begin + source.size();
+
+    lineStarts_.push_back(0);
+    for (const char* p = begin; p < end; ) {
+        p += scan.untilNewline(p, end);
+        if (p == end) break;
+        ++p;
+        lineStarts_.push_back(static_cast<uint64_t>(p - begin));
+    }
+}
+
+LineColumn LineIndex::resolve(uint64_t offset) const {
+    auto it = std::upper_bound(lineStarts_.begin(), lineStarts_.end(), offset);
+    size_t line = static_cast<size_t>(it - lineStarts_.begin()) - 1;
+    return {static_cast<uint64_t>(line) + 1, offset - lineStarts_[line] + 1};
+}
@@ -1,66 +1,90 @@
-#include "../include/lexer.h"
-#include "../include/parser.h"
-#include "../include/dot_export.h"
-#include "../include/json_export.h"
+#include "../include/driver.h"
+#include "../include/batch.h"
+#include "../include/parse_cache.h"
 
+#include <algorithm>
 #include <iostream>
-#include <fstream>
-#include <sstream>
+#include <memory>
 #include <cstring>
-
-static const size_t READ_BLOCK_SIZE = 4096;
-
-static std::string readFile(const std::string& path) {
-    std::ifstream in(path, std::ios::in | std::ios::binary);
-    if (!in.is_open()) {
-        throw std::runtime_error("Cannot open input file: " + path);
-    }
-
-    std::string content;
-    char buffer[READ_BLOCK_SIZE];
-    while (in.read(buffer, READ_BLOCK_SIZE)) {
-        content.append(buffer, in.gcount());
-    }
-    content.append(buffer, in.gcount());
-    return content;
-}
-
-static void writeFile(const std::string& path, const std::string& content) {
-    std::ofstream out(path, std::ios::out | std::ios::binary);
-    if (!out.is_open()) {
-        throw std::runtime_error("Cannot open output file: " + path);
-    }
-
-    size_t written = 0;
-    while (written < content.size()) {
-        size_t chunk = std::min(READ_BLOCK_SIZE, content.size() - written);
-        out.write(content.data() + written, static_cast<std::streamsize>(chunk));
-        written += chunk;
-    }
-}
+#include <cstdlib>
+#include <thread>
 
 static void printUsage(const char* progName) {
     std::cerr << "Usage: " << progName << " [options] <input-file> <output-file>\n"
+              << "       " << progName << " [options] --out-dir=DIR <input>...\n"
               << "\n"
               << "Options:\n"
               << "  --format=dot   Output in Graphviz DOT format (default)\n"
               << "  --format=json  Output in JSON format\n"
+              << "  --format=json-compact\n"
+              << "                 Output in JSON format without whitespace\n"
+              << "  --format=bin   Output in the binary AST format (binary_ast.h)\n"
+              << "  --max-depth=N  Reject statements/expressions nested deeper\n"
+              << "                 than N levels (default " << ParserOptions().maxDepth << ")\n"
+              << "  --jobs=N       Parse and export top-level functions on N threads\n"
+              << "                 (default 1); in batch mode, process N files at\n"
+              << "                 once (default: one per core)\n"
+              << "  --outline      Parse function signatures only, skipping bodies\n"
+              << "  --pipeline     Lex on a separate thread while parsing; not with\n"
+              << "                 --jobs above 1 except in batch mode\n"
+              << "  --out-dir=DIR  Batch mode: parse every input, writing the trees\n"
+              << "                 to DIR. An input is a source file, a directory\n"
+              << "                 (its *.v4 files) or @file with one path per line\n"
+              << "  --cache-dir=DIR\n"
+              << "                 Reuse results stored in DIR for unchanged inputs\n"
+              << "                 and store new ones there\n"
+              << "  --version      Print the version and exit\n"
               << "\n"
               << "Parses a source file (Variant 4 language) and outputs the\n"
-              << "syntax tree in the specified format.\n";
+              << "syntax tree in the specified format. Use '-' as the input\n"
+              << "file to read the source from stdin, or as the output file\n"
+              << "to write the tree to stdout.\n";
 }
 
 int main(int argc, char* argv[]) {
-    enum Format { FMT_DOT, FMT_JSON };
-    Format format = FMT_DOT;
+    DriverOptions options;
+    size_t jobs = 0;
+    std::string outputDir;
+    std::unique_ptr<ParseCache> cache;
 
     int argIdx = 1;
-    while (argIdx < argc && argv[argIdx][0] == '-') {
+    while (argIdx < argc && argv[argIdx][0] == '-' && argv[argIdx][1] != '\0') {
         std::string arg = argv[argIdx];
         if (arg == "--format=dot") {
-            format = FMT_DOT;
+            options.format = OutputFormat::DOT;
         } else if (arg == "--format=json") {
-            format = FMT_JSON;
+            options.format = OutputFormat::JSON;
+        } else if (arg == "--format=json-compact") {
+            options.format = OutputFormat::JSON_COMPACT;
+        } else if (arg == "--format=bin") {
+            options.format = OutputFormat::BIN;
+        } else if (arg.compare(0, 12, "--max-depth=") == 0) {
+            char* end = nullptr;
+            unsigned long long depth = std::strtoull(arg.c_str() + 12, &end, 10);
+            if (end == arg.c_str() + 12 || *end != '\0' || depth == 0) {
+                std::cerr << "Invalid value for --max-depth: " << arg.substr(12) << "\n";
+                return 1;
+            }
+            options.parser.maxDepth = static_cast<size_t>(depth);
+        } else if (arg.compare(0, 7, "--jobs=") == 0) {
+            char* end = nullptr;
+            unsigned long long n = std::strtoull(arg.c_str() + 7, &end, 10);
+            if (end == arg.c_str() + 7 || *end != '\0' || n == 0) {
+                std::cerr << "Invalid value for --jobs: " << arg.substr(7) << "\n";
+                return 1;
+            }
+            jobs = static_cast<size_t>(n);
+        } else if (arg == "--outline") {
+            options.parser.outline = true;
+        } else if (arg == "--pipeline") {
+            options.pipeline = true;
+        } else if (arg.compare(0, 10, "--out-dir=") == 0 && arg.size() > 10) {
+            outputDir = arg.substr(10);
+        } else if (arg.compare(0, 12, "--cache-dir=") == 0 && arg.size() > 12) {
+            cache = std::make_unique<ParseCache>(arg.substr(12));
+        } else if (arg == "--version") {
+            std::cout << PARSER_VERSION << "\n";
+            return 0;
         } else if (arg == "--help" || arg == "-h") {
             printUsage(argv[0]);
             return 0;
@@ -72,60 +96,57 @@ int main(int argc, char* argv[]) {
         argIdx++;
     }
 
-    if (argc - argIdx != 2) {
-        printUsage(argv[0]);
-        return 1;
-    }
-
-    const char* inputPath = argv[argIdx];
-    const char* outputPath = argv[argIdx + 1];
-
-    std::string source;
-    try {
-        source = readFile(inputPath);
-    } catch (const std::exception& e) {
-        std::cerr << "Error: " << e.what() << "\n";
+    // A file is either split across the pool or lexed on a thread of its
+    // own; batch mode pipelines each file and runs --jobs files at once.
+    if (options.pipeline && jobs > 1 && outputDir.empty()) {
+        std::cerr << "--pipeline cannot be combined with --jobs greater than 1\n";
         return 1;
     }
 
-    Lexer lexer(source);
-    std::vector<Token> tokens = lexer.tokenize();
-
-    bool hasErrors = false;
-    for (const auto& err : lexer.errors()) {
-        std::cerr << inputPath << ":" << err.loc.line << ":" << err.loc.column
-                  << ": lexer error: " << err.message << "\n";
-        hasErrors = true;
-    }
-
-    Parser parser(tokens);
-    ParseResult result = parser.parse();
-
-    for (const auto& err : result.errors) {
-        std::cerr << inputPath << ":" << err.loc.line << ":" << err.loc.column
-                  << ": parse error: " << err.message << "\n";
-        hasErrors = true;
-    }
-
-    if (result.tree) {
-        std::string output;
-        switch (format) {
-            case FMT_DOT:
-                output = DotExporter::exportTree(result.tree.get());
-                break;
-            case FMT_JSON:
-                output = JsonExporter::exportTree(result.tree.get());
-                break;
+    if (!outputDir.empty()) {
+        if (argIdx == argc) {
+            printUsage(argv[0]);
+            return 1;
         }
-
+        // Files are the unit of work here; each one is parsed on a
+        // single thread.
+        std::vector<BatchFile> files;
         try {
-            writeFile(outputPath, output);
+            files = collectBatch(std::vector<std::string>(argv + argIdx, argv + argc), outputDir,
+                                 options.format);
         } catch (const std::exception& e) {
             std::cerr << "Error: " << e.what() << "\n";
             return 1;
         }
-        std::cout << "Syntax tree written to " << outputPath << "\n";
+        if (jobs == 0) jobs = std::max(1u, std::thread::hardware_concurrency());
+        ThreadPool pool(std::min(jobs, std::max<size_t>(files.size(), 1)));
+        return runBatch(files, options, pool, std::cerr, std::cout, cache.get()) ? 0 : 1;
     }
 
-    return hasErrors ? 1 : 0;
+    if (argc - argIdx != 2) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    const char* inputPath = argv[argIdx];
+    const char* outputPath = argv[argIdx + 1];
+
+    // With --jobs the pool is used by both the parser and the exporters.
+    std::unique_ptr<ThreadPool> pool;
+    if (jobs > 1) pool = std::make_unique<ThreadPool>(jobs);
+
+    // The parser recurses once per nesting level and parseParallel()
+    // parses on the calling thread too, so the file is processed on a
+    // thread whose stack does not depend on the main thread's limit.
+    ThreadPool mainThread(1);
+    FileResult result = mainThread.submit([&] {
+        return cache ? cache->process(inputPath, outputPath, options, std::cerr, pool.get())
+                     : processFile(inputPath, outputPath, options, std::cerr, pool.get());
+    }).get();
+    if (result.failed) return 1;
+    if (std::strcmp(outputPath, "-") != 0) {
+        if (result.written) std::cout << "Syntax tree written to " << outputPath << "\n";
+        if (cache) cache->report(std::cout);
+    }
+    return result.errors > 0 ? 1 : 0;
 }
@@ -0,0 +1,133 @@
+#include "../include/output_buffer.h"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static int openForWriting(const std::string& path) {
+#if defined(_WIN32)
+    return _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    return open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+#endif
+}
+
+// Writes all of data to fd; false on error.
+static bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+#if defined(_WIN32)
+        unsigned chunk = static_cast<unsigned>(std::min<size_t>(size, 1u << 30));
+        int written = _write(fd, data, chunk);
+#else
+        ssize_t written = ::write(fd, data, size);
+#endif
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+OutputBuffer::OutputBuffer(const std::string& path, size_t capacity)
+    : data_(std::make_unique<char[]>(capacity)), capacity_(capacity), path_(path) {
+    fd_ = openForWriting(path);
+    if (fd_ < 0) {
+        throw std::runtime_error("Cannot open output file: " + path);
+    }
+    ownsFd_ = true;
+}
+
+OutputBuffer::OutputBuffer(int fd, size_t capacity)
+    : data_(std::make_unique<char[]>(capacity)), capacity_(capacity), fd_(fd) {}
+
+OutputBuffer::OutputBuffer(std::ostream& out, size_t capacity)
+    : data_(std::make_unique<char[]>(capacity)), capacity_(capacity), stream_(&out) {}
+
+OutputBuffer::OutputBuffer(std::string& out, size_t capacity)
+    : data_(std::make_unique<char[]>(capacity)), capacity_(capacity), string_(&out) {}
+
+OutputBuffer::~OutputBuffer() {
+    try {
+        flush();
+    } catch (const std::exception&) {
+        // Reported only by an explicit flush().
+    }
+    if (ownsFd_) {
+#if defined(_WIN32)
+        _close(fd_);
+#else
+        close(fd_);
+#endif
+    }
+}
+
+void OutputBuffer::flush() {
+    size_t size = size_;
+    size_ = 0;
+    writeToSink(data_.get(), size);
+}
+
+void OutputBuffer::writeSlow(std::string_view s) {
+    flush();
+    if (s.size() >= capacity_) {
+        // Larger than the whole buffer: pass it straight through.
+        writeToSink(s.data(), s.size());
+        return;
+    }
+    std::memcpy(data_.get(), s.data(), s.size());
+    size_ = s.size();
+}
+
+void OutputBuffer::writeToSink(const char* data, size_t size) {
+    if (!failed_ && size == 0) return;
+    if (!failed_) {
+        if (string_) {
+            string_->append(data, size);
+        } else if (stream_) {
+            failed_ = !stream_->write(data, static_cast<std::streamsize>(size));
+        } else {
+            failed_ = !writeAll(fd_, data, size);
+        }
+    }
+    if (failed_) {
+        throw std::runtime_error(path_.empty() ? "Cannot write output"
+                                               : "Cannot write output file: " + path_);
+    }
+    if (copy_) {
+        try {
+            copy_->write(std::string_view(data, size));
+        } catch (const std::exception&) {
+            copy_ = nullptr;
+        }
+    }
+}
+
+void OutputBuffer::writeNumber(uint64_t value) {
+    char digits[20];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    write(std::string_view(digits, static_cast<size_t>(result.ptr - digits)));
+}
+
+void OutputBuffer::writeEscaped(std::string_view s, const EscapeTable& table) {
+    size_t plain = 0;
+    for (size_t i = 0; i < s.size(); ++i) {
+        std::string_view replacement = table.replacement[static_cast<unsigned char>(s[i])];
+        if (replacement.empty()) continue;
+        write(s.substr(plain, i - plain));
+        write(replacement);
+        plain = i + 1;
+    }
+    write(s.substr(plain));
+}
@@ -0,0 +1,96 @@
+#include "../include/parallel_export.h"
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <vector>
+
+// Nodes per rendered batch: big enough to amortize a task, small enough
+// that the batches in flight stay a few megabytes.
+static const uint64_t BATCH_NODES = 32 * 1024;
+// Batches in flight per worker.
+static const size_t BATCHES_PER_WORKER = 2;
+// Staging buffer of each batch; the batch string grows past it.
+static const size_t BATCH_BUFFER_SIZE = 64 * 1024;
+
+namespace {
+
+uint64_t countNodes(const ASTNode* root) {
+    if (!root) return 0;
+    uint64_t count = 0;
+    std::vector<const ASTNode*> stack{root};
+    while (!stack.empty()) {
+        const ASTNode* node = stack.back();
+        stack.pop_back();
+        count++;
+        for (const ASTNode* child : node->children) {
+            if (child) stack.push_back(child);
+        }
+    }
+    return count;
+}
+
+struct Batch {
+    size_t first;
+    size_t last;
+    uint64_t firstNode;
+};
+
+} // namespace
+
+void renderItemsParallel(const ASTNode* root, ThreadPool& pool, OutputBuffer& out,
+                         const RenderItems& render) {
+    const auto& items = root->children;
+    if (items.empty()) return;
+
+    // Subtree sizes, counted in slices on the pool.
+    std::vector<uint64_t> sizes(items.size());
+    size_t slice = std::max<size_t>(1, items.size() / (pool.size() * 8));
+    std::vector<std::future<void>> counting;
+    for (size_t from = 0; from < items.size(); from += slice) {
+        size_t to = std::min(items.size(), from + slice);
+        counting.push_back(pool.submit([&items, &sizes, from, to]() {
+            for (size_t i = from; i < to; ++i) sizes[i] = countNodes(items[i]);
+        }));
+    }
+    // The tasks reference locals: all must finish before an exception
+    // from one of them is rethrown.
+    for (auto& future : counting) future.wait();
+    for (auto& future : counting) future.get();
+
+    std::vector<Batch> batches;
+    uint64_t node = 1;
+    for (size_t i = 0; i < items.size();) {
+        Batch batch{i, i, node};
+        uint64_t batchNodes = 0;
+        while (batch.last < items.size() && batchNodes < BATCH_NODES) {
+            batchNodes += sizes[batch.last++];
+        }
+        node += batchNodes;
+        batches.push_back(batch);
+        i = batch.last;
+    }
+
+    size_t window = pool.size() * BATCHES_PER_WORKER;
+    std::deque<std::future<std::string>> pending;
+    size_t next = 0;
+    try {
+        while (next < batches.size() || !pending.empty()) {
+            while (next < batches.size() && pending.size() < window) {
+                Batch batch = batches[next++];
+                pending.push_back(pool.submit([&render, batch]() {
+                    std::string text;
+                    OutputBuffer chunk(text, BATCH_BUFFER_SIZE);
+                    render(chunk, batch.first, batch.last, batch.firstNode);
+                    chunk.flush();
+                    return text;
+                }));
+            }
+            std::string text = pending.front().get();
+            pending.pop_front();
+            out.write(text);
+        }
+    } catch (...) {
+        for (auto& future : pending) future.wait();
+        throw;
+    }
+}
@@ -0,0 +1,112 @@
+#include "../include/parallel_parser.h"
+#include <algorithm>
+#include <utility>
+
+// Ranges smaller than this are not worth a task.
+static const size_t MIN_RANGE_TOKENS = 16 * 1024;
+// Ranges per worker, so uneven functions still balance.
+static const size_t RANGES_PER_WORKER = 4;
+// How far past an even split point to look for a 'def'.
+static const size_t CUT_SEARCH_LIMIT = 64 * 1024;
+
+namespace {
+
+struct RangeResult {
+    ParseResult parsed;
+    size_t start;
+    size_t end;
+    bool aborted;
+};
+
+// Parses the items starting at token start until at least token stop
+// has been reached. Depends on nothing before start: a Parser at the top
+// level carries no state besides its position.
+RangeResult parseRange(const std::vector<Token>& tokens, size_t start, size_t stop,
+                       ParserOptions options) {
+    TokenVectorSource source(tokens, start);
+    Parser parser(source, options);
+    ParseResult parsed = parser.parseSourceItems(stop - start);
+    return {std::move(parsed), start, start + parser.consumed(), parser.aborted()};
+}
+
+// Cut points: the first 'def' following an 'end' near each even split.
+// That is where a top-level function usually starts.
+std::vector<size_t> planCuts(const std::vector<Token>& tokens, size_t ranges) {
+    std::vector<size_t> cuts{0};
+    size_t last = tokens.size() - 1; // TOK_EOF
+    for (size_t r = 1; r < ranges; ++r) {
+        size_t from = last * r / ranges;
+        if (from <= cuts.back()) from = cuts.back() + 1;
+        size_t limit = std::min(last, from + CUT_SEARCH_LIMIT);
+        for (size_t i = from; i < limit; ++i) {
+            if (tokens[i].type == TokenType::TOK_DEF && tokens[i - 1].type == TokenType::TOK_END) {
+                cuts.push_back(i);
+                break;
+            }
+        }
+    }
+    return cuts;
+}
+
+} // namespace
+
+ParseResult parseParallel(const std::vector<Token>& tokens, ThreadPool& pool,
+                          ParserOptions options) {
+    size_t ranges = std::min(pool.size() * RANGES_PER_WORKER, tokens.size() / MIN_RANGE_TOKENS);
+    if (pool.size() <= 1 || ranges <= 1) {
+        return Parser(tokens, options).parse();
+    }
+
+    std::vector<size_t> cuts = planCuts(tokens, ranges);
+    std::vector<std::future<RangeResult>> pending;
+    pending.reserve(cuts.size());
+    for (size_t c = 0; c < cuts.size(); ++c) {
+        size_t start = cuts[c];
+        size_t stop = c + 1 < cuts.size() ? cuts[c + 1] : tokens.size();
+        pending.push_back(pool.submit([&tokens, start, stop, options]() {
+            return parseRange(tokens, start, stop, options);
+        }));
+    }
+
+    ParseResult result;
+    result.arena = std::make_unique<AstArena>();
+    result.tree = result.arena->makeNode(ASTNode::SOURCE, tokens.front().loc);
+
+    size_t eof = tokens.size() - 1;
+    size_t pos = 0;
+    size_t next = 0; // first cut not yet used or skipped
+    for (;;) {
+        while (next < cuts.size() && cuts[next] < pos) {
+            pending[next++].wait();
+        }
+
+        RangeResult range;
+        if (next < cuts.size() && cuts[next] == pos) {
+            range = pending[next++].get();
+        } else {
+            // The previous range overran a cut: parse up to the next one here.
+            size_t stop = next < cuts.size() ? cuts[next] : tokens.size();
+            range = parseRange(tokens, pos, stop, options);
+        }
+
+        for (ASTNodePtr item : range.parsed.tree->children) {
+            result.tree->addChild(item);
+        }
+        for (ParseError& err : range.parsed.errors) {
+            result.errors.push_back(std::move(err));
+        }
+        // Body token indices count from the start of the range.
+        for (BodyRange& body : range.parsed.bodies) {
+            body.firstToken += range.start;
+            result.bodies.push_back(body);
+        }
+        result.arena->adopt(std::move(range.parsed.arena));
+
+        pos = range.end;
+        if (range.aborted || pos >= eof) break;
+    }
+
+    // Tasks still running reference tokens; let them finish.
+    for (; next < pending.size(); ++next) pending[next].wait();
+    return result;
+}
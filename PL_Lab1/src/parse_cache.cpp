@@ -0,0 +1,278 @@
+#include "../include/parse_cache.h"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <sstream>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// XXH64 (Yann Collet's xxHash, 64-bit variant): several GB/s, so hashing
+// costs a small fraction of lexing the same bytes. Words are read in
+// native byte order; entries are not meant to move between machines.
+const uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+const uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+const uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+const uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+const uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+uint64_t read64(const unsigned char* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint32_t read32(const unsigned char* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint64_t round64(uint64_t acc, uint64_t input) {
+    acc += input * PRIME64_2;
+    acc = rotl(acc, 31);
+    return acc * PRIME64_1;
+}
+
+uint64_t mergeRound(uint64_t acc, uint64_t value) {
+    acc ^= round64(0, value);
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+uint64_t xxh64(std::string_view data, uint64_t seed) {
+    const auto* p = reinterpret_cast<const unsigned char*>(data.data());
+    const unsigned char* end = p + data.size();
+    uint64_t h;
+
+    if (data.size() >= 32) {
+        uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+        uint64_t v2 = seed + PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME64_1;
+        const unsigned char* limit = end - 32;
+        do {
+            v1 = round64(v1, read64(p));
+            v2 = round64(v2, read64(p + 8));
+            v3 = round64(v3, read64(p + 16));
+            v4 = round64(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = mergeRound(h, v1);
+        h = mergeRound(h, v2);
+        h = mergeRound(h, v3);
+        h = mergeRound(h, v4);
+    } else {
+        h = seed + PRIME64_5;
+    }
+    h += data.size();
+
+    for (; p + 8 <= end; p += 8) {
+        h ^= round64(0, read64(p));
+        h = rotl(h, 27) * PRIME64_1 + PRIME64_4;
+    }
+    if (p + 4 <= end) {
+        h ^= read32(p) * PRIME64_1;
+        h = rotl(h, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h ^= *p * PRIME64_5;
+        h = rotl(h, 11) * PRIME64_1;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+constexpr char ENTRY_MAGIC[8] = {'V', '4', 'C', 'A', 'C', 'H', 'E', '2'};
+
+// An entry is the output, then diagnosticsSize bytes of diagnostics, each
+// a uint64_t size and the text without the input path, then this trailer.
+// The output is copied into the entry while it is exported, so the sizes
+// are written last; so is the magic, which a truncated entry lacks.
+struct EntryTrailer {
+    uint64_t errors;
+    uint64_t written;
+    uint64_t diagnosticsSize;
+    char magic[8];
+};
+
+// Distinguishes the temporary files of concurrent writers, in this
+// process and in others sharing the directory.
+std::string temporarySuffix() {
+    static const uint64_t processTag =
+        (uint64_t(std::random_device{}()) << 32 | std::random_device{}()) ^
+        static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    static std::atomic<uint64_t> counter{0};
+    std::ostringstream suffix;
+    suffix << ".tmp." << std::hex << processTag << "." << counter++;
+    return suffix.str();
+}
+
+} // namespace
+
+std::string CacheKey::hex() const {
+    static const char digits[] = "0123456789abcdef";
+    std::string text(32, '0');
+    for (int i = 0; i < 16; ++i) {
+        text[15 - i] = digits[(high >> (4 * i)) & 0xF];
+        text[31 - i] = digits[(low >> (4 * i)) & 0xF];
+    }
+    return text;
+}
+
+ParseCache::ParseCache(std::string dir) : dir_(std::move(dir)) {}
+
+CacheKey ParseCache::key(std::string_view source, const DriverOptions& options) {
+    // Everything besides the source that changes the result. --jobs and
+    // --pipeline do not: their output is identical.
+    std::ostringstream settings;
+    settings << PARSER_VERSION << '\0' << static_cast<int>(options.format) << '\0'
+             << options.parser.maxDepth << '\0' << options.parser.outline;
+    uint64_t seed = xxh64(settings.str(), 0);
+    return {xxh64(source, seed), xxh64(source, seed ^ PRIME64_1)};
+}
+
+std::string ParseCache::entryPath(const CacheKey& key) const {
+    // Two-character subdirectories keep directories small.
+    std::string hex = key.hex();
+    return (fs::path(dir_) / hex.substr(0, 2) / hex.substr(2)).string();
+}
+
+FileResult ParseCache::process(const std::string& inputPath, const std::string& outputPath,
+                               const DriverOptions& options, std::ostream& diagnostics,
+                               ThreadPool* pool) {
+    FileResult result;
+    SourceBuffer source;
+    try {
+        source = readSource(inputPath);
+    } catch (const std::exception& e) {
+        diagnostics << "Error: " << e.what() << "\n";
+        result.failed = true;
+        return result;
+    }
+
+    std::string path = entryPath(key(source.view(), options));
+    if (replay(path, inputPath, outputPath, diagnostics, result)) {
+        hits_++;
+        return result;
+    }
+    misses_++;
+
+    // Output to stdout is not stored. Otherwise the output is written to
+    // the entry as well as it is exported. A cache that cannot be written
+    // only costs the next run a miss.
+    std::unique_ptr<OutputBuffer> entry;
+    const std::string temporary = path + temporarySuffix();
+    if (outputPath != "-") {
+        std::error_code ec;
+        fs::create_directories(fs::path(path).parent_path(), ec);
+        try {
+            entry = std::make_unique<OutputBuffer>(temporary);
+        } catch (const std::exception&) {
+        }
+    }
+
+    std::vector<std::string> located;
+    result = processSource(std::move(source), inputPath, outputPath, options, diagnostics, pool,
+                           &located, entry.get());
+    if (entry) store(std::move(entry), temporary, path, located, result);
+    return result;
+}
+
+bool ParseCache::replay(const std::string& path, const std::string& inputPath,
+                        const std::string& outputPath, std::ostream& diagnostics,
+                        FileResult& result) const {
+    SourceBuffer entry;
+    try {
+        entry = SourceBuffer::fromFile(path);
+    } catch (const std::exception&) {
+        return false;
+    }
+    EntryTrailer trailer;
+    if (entry.size() < sizeof(trailer)) return false;
+    uint64_t body = entry.size() - sizeof(trailer);
+    std::memcpy(&trailer, entry.data() + body, sizeof(trailer));
+    if (std::memcmp(trailer.magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC)) != 0 ||
+        trailer.diagnosticsSize > body) {
+        return false;
+    }
+    std::string_view output(entry.data(), body - trailer.diagnosticsSize);
+    std::vector<std::string_view> located;
+    const char* records = entry.data() + output.size();
+    for (uint64_t pos = 0; pos < trailer.diagnosticsSize;) {
+        uint64_t size;
+        if (trailer.diagnosticsSize - pos < sizeof(size)) return false;
+        std::memcpy(&size, records + pos, sizeof(size));
+        pos += sizeof(size);
+        if (size > trailer.diagnosticsSize - pos) return false;
+        located.emplace_back(records + pos, size);
+        pos += size;
+    }
+
+    for (std::string_view text : located) diagnostics << inputPath << ":" << text << "\n";
+    result.errors = trailer.errors;
+    if (trailer.written) {
+        try {
+            std::unique_ptr<OutputBuffer> out = openOutput(outputPath);
+            out->write(output);
+            out->flush();
+        } catch (const std::exception& e) {
+            diagnostics << "Error: " << e.what() << "\n";
+            result.failed = true;
+            return true;
+        }
+        result.written = true;
+    }
+    return true;
+}
+
+// entry already holds the output; completes it and renames it into
+// place, or removes it if the run or any write to the entry failed.
+void ParseCache::store(std::unique_ptr<OutputBuffer> entry, const std::string& temporary,
+                       const std::string& path, const std::vector<std::string>& located,
+                       const FileResult& result) const {
+    std::error_code ec;
+    bool complete = !result.failed;
+    if (complete) {
+        EntryTrailer trailer{};
+        trailer.errors = result.errors;
+        trailer.written = result.written;
+        std::memcpy(trailer.magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC));
+        try {
+            for (const std::string& text : located) {
+                uint64_t size = text.size();
+                entry->write(std::string_view(reinterpret_cast<const char*>(&size), sizeof(size)));
+                entry->write(text);
+                trailer.diagnosticsSize += sizeof(size) + text.size();
+            }
+            entry->write(std::string_view(reinterpret_cast<const char*>(&trailer), sizeof(trailer)));
+            entry->flush();
+        } catch (const std::exception&) {
+            complete = false;
+        }
+    }
+    entry.reset();
+    if (!complete) {
+        fs::remove(temporary, ec);
+        return;
+    }
+    // Replaces any entry another writer renamed into place meanwhile;
+    // both have the same contents.
+    fs::rename(temporary, path, ec);
+    if (ec) fs::remove(temporary, ec);
+}
+
+void ParseCache::report(std::ostream& out) const {
+    out << "Cache: " << hits_ << " hits, " << misses_ << " misses\n";
+}
@@ -1,21 +1,72 @@
 #include "../include/parser.h"
 #include <stdexcept>
 
-Parser::Parser(const std::vector<Token>& tokens)
-    : tokens_(tokens), pos_(0) {}
+// Names an identifier node by symbol. When expect() failed, name is
+// whatever token was there instead and its text is kept as the value.
+static void setName(ASTNode& node, const Token& name) {
+    if (name.type == TokenType::TOK_IDENT) {
+        node.symbol = name.symbol;
+    } else {
+        node.value = name.text;
+    }
+}
+
+static BuiltinType builtinType(TokenType type) {
+    switch (type) {
+        case TokenType::TOK_BOOL:       return BuiltinType::BOOL;
+        case TokenType::TOK_BYTE:       return BuiltinType::BYTE;
+        case TokenType::TOK_INT:        return BuiltinType::INT;
+        case TokenType::TOK_UINT:       return BuiltinType::UINT;
+        case TokenType::TOK_LONG:       return BuiltinType::LONG;
+        case TokenType::TOK_ULONG:      return BuiltinType::ULONG;
+        case TokenType::TOK_CHARTYPE:   return BuiltinType::CHAR;
+        case TokenType::TOK_STRINGTYPE: return BuiltinType::STRING;
+        default:                        return BuiltinType::NONE;
+    }
+}
+
+static LoopKind loopKind(TokenType type) {
+    return type == TokenType::TOK_UNTIL ? LoopKind::UNTIL : LoopKind::WHILE;
+}
+
+static Operator prefixOperator(TokenType type) {
+    switch (type) {
+        case TokenType::TOK_MINUS:  return Operator::NEG;
+        case TokenType::TOK_TILDE:  return Operator::BIT_NOT;
+        case TokenType::TOK_BANG:   return Operator::NOT;
+        case TokenType::TOK_INC:    return Operator::PRE_INC;
+        case TokenType::TOK_DEC_OP: return Operator::PRE_DEC;
+        default:                    return Operator::NONE;
+    }
+}
+
+Parser::Parser(const std::vector<Token>& tokens, ParserOptions options)
+    : ownedSource_(std::make_unique<TokenVectorSource>(tokens)), source_(*ownedSource_), head_(0),
+      options_(options) {
+    window_[0] = source_.next();
+    window_[1] = source_.next();
+}
+
+Parser::Parser(TokenSource& source, ParserOptions options)
+    : source_(source), head_(0), options_(options) {
+    window_[0] = source_.next();
+    window_[1] = source_.next();
+}
 
 const Token& Parser::current() const {
-    return tokens_[pos_];
+    return window_[head_ % WINDOW];
 }
 
 const Token& Parser::peekToken() const {
-    if (pos_ + 1 < tokens_.size()) return tokens_[pos_ + 1];
-    return tokens_.back();
+    return window_[(head_ + 1) % WINDOW];
 }
 
 const Token& Parser::advance() {
-    const Token& tok = tokens_[pos_];
-    if (pos_ + 1 < tokens_.size()) pos_++;
+    const Token& tok = current();
+    if (tok.type != TokenType::TOK_EOF) {
+        head_++;
+        window_[(head_ + 1) % WINDOW] = source_.next();
+    }
     return tok;
 }
 
@@ -35,7 +86,7 @@ const Token& Parser::expect(TokenType type, const std::string& context) {
     if (check(type)) {
         return advance();
     }
-    error("expected '" + context + "', got '" + current().text + "'");
+    error("expected '" + context + "', got '" + std::string(current().text) + "'");
     return current();
 }
 
@@ -43,14 +94,39 @@ bool Parser::isAtEnd() const {
     return current().type == TokenType::TOK_EOF;
 }
 
+uint64_t Parser::consumedEnd() const {
+    if (head_ == 0) return current().loc.offset;
+    const Token& last = window_[(head_ - 1) % WINDOW];
+    return last.loc.offset + last.text.size();
+}
+
+uint64_t Parser::lookaheadEnd() const {
+    const Token& ahead = peekToken();
+    return ahead.loc.offset + ahead.text.size();
+}
+
 void Parser::error(const std::string& msg) {
-    errors_.push_back({msg, current().loc});
+    error(msg, current().loc);
 }
 
 void Parser::error(const std::string& msg, SourceLocation loc) {
+    if (aborted_) return;
     errors_.push_back({msg, loc});
 }
 
+Parser::DepthGuard::DepthGuard(Parser& parser)
+    : parser_(parser), tooDeep_(++parser.depth_ > parser.options_.maxDepth) {
+    if (tooDeep_ && !parser_.aborted_) parser_.abortTooDeep();
+}
+
+void Parser::abortTooDeep() {
+    error("nesting is deeper than " + std::to_string(options_.maxDepth) + " levels");
+    aborted_ = true;
+    Token eof{TokenType::TOK_EOF, NO_SYMBOL, {}, current().loc, {}};
+    window_[head_ % WINDOW] = eof;
+    window_[(head_ + 1) % WINDOW] = eof;
+}
+
 void Parser::synchronize() {
     while (!isAtEnd()) {
         if (check(TokenType::TOK_SEMICOLON)) { advance(); return; }
@@ -65,24 +141,65 @@ void Parser::synchronize() {
 }
 
 ParseResult Parser::parse() {
-    auto tree = parseSource();
-    return {std::move(tree), std::move(errors_)};
+    return parseOwned(SIZE_MAX);
+}
+
+ParseResult Parser::parseSourceItems(size_t minTokens) {
+    return parseOwned(minTokens);
+}
+
+ParseResult Parser::parseOwned(size_t minTokens) {
+    ownedArena_ = std::make_unique<AstArena>();
+    arena_ = ownedArena_.get();
+    auto tree = parseSource(minTokens);
+    arena_ = nullptr;
+    return {std::move(ownedArena_), tree, std::move(errors_), std::move(bodies_)};
+}
+
+ASTNodePtr Parser::parseItem(AstArena& arena) {
+    arena_ = &arena;
+    auto item = parseSourceStep();
+    arena_ = nullptr;
+    return item;
+}
+
+void Parser::parseBody(const BodyRange& body, AstArena& arena) {
+    arena_ = &arena;
+    parseFuncBody(body.func);
+    arena_ = nullptr;
+}
+
+FlatParseResult Parser::parseFlat() {
+    ParseResult result = parse();
+    return {FlatAst::fromTree(result.tree), std::move(result.errors)};
 }
 
 // source: sourceItem*
-ASTNodePtr Parser::parseSource() {
+ASTNodePtr Parser::parseSource(size_t minTokens) {
     auto node = makeNode(ASTNode::SOURCE, current().loc);
-    while (!isAtEnd()) {
-        auto item = parseSourceItem();
-        if (item) {
-            node->addChild(std::move(item));
-        } else {
-            synchronize();
+    while (!isAtEnd() && head_ < minTokens) {
+        if (auto item = parseSourceStep()) {
+            node->addChild(item);
         }
     }
     return node;
 }
 
+// One iteration of source: an item, or nullptr once the tokens that
+// could not start one were skipped.
+ASTNodePtr Parser::parseSourceStep() {
+    auto item = parseSourceItem();
+    if (!item) {
+        // synchronize() stops in front of statement keywords and 'end',
+        // none of which can start a top-level item; step over one so
+        // the caller always makes progress.
+        size_t before = head_;
+        synchronize();
+        if (head_ == before) advance();
+    }
+    return item;
+}
+
 // sourceItem: funcDef
 ASTNodePtr Parser::parseSourceItem() {
     if (check(TokenType::TOK_DEF)) {
@@ -100,12 +217,21 @@ ASTNodePtr Parser::parseFuncDef() {
     auto node = makeNode(ASTNode::FUNC_DEF, loc);
     node->addChild(parseFuncSignature());
 
+    if (options_.outline) {
+        skipFuncBody(node);
+    } else {
+        parseFuncBody(node);
+    }
+    return node;
+}
+
+void Parser::parseFuncBody(ASTNodePtr func) {
     if (!check(TokenType::TOK_END) && !isAtEnd() && !check(TokenType::TOK_DEF)) {
         while (!check(TokenType::TOK_END) && !isAtEnd()) {
             if (check(TokenType::TOK_DEF)) break;
             auto stmt = parseStatement();
             if (stmt) {
-                node->addChild(std::move(stmt));
+                func->addChild(stmt);
             } else {
                 synchronize();
             }
@@ -115,8 +241,6 @@ ASTNodePtr Parser::parseFuncDef() {
     if (check(TokenType::TOK_END)) {
         advance();
     }
-
-    return node;
 }
 
 // funcSignature: identifier '(' list<arg> ')' ('of' typeRef)?
@@ -125,7 +249,7 @@ ASTNodePtr Parser::parseFuncSignature() {
     auto node = makeNode(ASTNode::FUNC_SIGNATURE, loc);
 
     const Token& name = expect(TokenType::TOK_IDENT, "function name");
-    node->value = name.text;
+    setName(*node, name);
 
     expect(TokenType::TOK_LPAREN, "(");
     if (!check(TokenType::TOK_RPAREN)) {
@@ -147,7 +271,8 @@ ASTNodePtr Parser::parseFuncSignature() {
 ASTNodePtr Parser::parseFuncArg() {
     auto loc = current().loc;
     const Token& name = expect(TokenType::TOK_IDENT, "argument name");
-    auto node = makeNode(ASTNode::FUNC_ARG, loc, name.text);
+    auto node = makeNode(ASTNode::FUNC_ARG, loc);
+    setName(*node, name);
     if (match(TokenType::TOK_OF)) {
         node->addChild(parseTypeRef());
     }
@@ -157,7 +282,7 @@ ASTNodePtr Parser::parseFuncArg() {
 // typeRef: builtin | custom | typeRef 'array' '[' dec ']'
 ASTNodePtr Parser::parseTypeRef() {
     auto loc = current().loc;
-    ASTNodePtr baseType;
+    ASTNodePtr baseType = nullptr;
 
     switch (current().type) {
         case TokenType::TOK_BOOL:
@@ -168,13 +293,13 @@ ASTNodePtr Parser::parseTypeRef() {
         case TokenType::TOK_ULONG:
         case TokenType::TOK_CHARTYPE:
         case TokenType::TOK_STRINGTYPE: {
-            auto tok = advance();
-            baseType = makeNode(ASTNode::TYPE_BUILTIN, loc, tok.text);
+            baseType = makeNode(ASTNode::TYPE_BUILTIN, loc);
+            baseType->builtin = builtinType(advance().type);
             break;
         }
         case TokenType::TOK_IDENT: {
-            auto tok = advance();
-            baseType = makeNode(ASTNode::TYPE_CUSTOM, loc, tok.text);
+            baseType = makeNode(ASTNode::TYPE_CUSTOM, loc);
+            setName(*baseType, advance());
             break;
         }
         default:
@@ -186,11 +311,12 @@ ASTNodePtr Parser::parseTypeRef() {
     while (check(TokenType::TOK_ARRAY)) {
         advance(); // 'array'
         expect(TokenType::TOK_LBRACKET, "[");
-        const Token& dim = expect(TokenType::TOK_DEC, "array dimension");
+        Token dim = expect(TokenType::TOK_DEC, "array dimension");
         expect(TokenType::TOK_RBRACKET, "]");
         auto arrNode = makeNode(ASTNode::TYPE_ARRAY, loc, dim.text);
-        arrNode->addChild(std::move(baseType));
-        baseType = std::move(arrNode);
+        arrNode->literal = dim.literal;
+        arrNode->addChild(baseType);
+        baseType = arrNode;
     }
 
     return baseType;
@@ -234,6 +360,9 @@ bool Parser::isExprStart() const {
 
 // statement: if | loop | repeat | break | block | expression/assign
 ASTNodePtr Parser::parseStatement() {
+    DepthGuard guard(*this);
+    if (guard.tooDeep()) return makeNode(ASTNode::EXPR_LITERAL, current().loc, "<error>");
+
     switch (current().type) {
         case TokenType::TOK_IF:
             return parseIfStatement();
@@ -278,13 +407,14 @@ ASTNodePtr Parser::parseLoopStatement() {
     auto loc = current().loc;
     const Token& kw = advance(); // 'while' or 'until'
 
-    auto node = makeNode(ASTNode::STMT_LOOP, loc, kw.text);
+    auto node = makeNode(ASTNode::STMT_LOOP, loc);
+    node->loop = loopKind(kw.type);
     node->addChild(parseExpression());
 
     while (!check(TokenType::TOK_END) && !isAtEnd()) {
         auto stmt = parseStatement();
         if (stmt) {
-            node->addChild(std::move(stmt));
+            node->addChild(stmt);
         } else {
             synchronize();
         }
@@ -305,11 +435,11 @@ ASTNodePtr Parser::parseBlock() {
     while (!check(closer) && !isAtEnd()) {
         if (check(TokenType::TOK_DEF)) {
             auto item = parseSourceItem();
-            if (item) node->addChild(std::move(item));
+            if (item) node->addChild(item);
             else synchronize();
         } else {
             auto stmt = parseStatement();
-            if (stmt) node->addChild(std::move(stmt));
+            if (stmt) node->addChild(stmt);
             else synchronize();
         }
     }
@@ -327,14 +457,14 @@ ASTNodePtr Parser::parseExpressionOrAssign() {
         auto rhs = parseExpression();
 
         auto assignNode = makeNode(ASTNode::STMT_ASSIGN, loc);
-        assignNode->addChild(std::move(expr));
-        assignNode->addChild(std::move(rhs));
+        assignNode->addChild(expr);
+        assignNode->addChild(rhs);
 
         // check for repeat: ... ('while'|'until') expr ';'
         if (check(TokenType::TOK_WHILE) || check(TokenType::TOK_UNTIL)) {
-            const Token& kw = advance();
-            auto repeatNode = makeNode(ASTNode::STMT_REPEAT, loc, kw.text);
-            repeatNode->addChild(std::move(assignNode));
+            auto repeatNode = makeNode(ASTNode::STMT_REPEAT, loc);
+            repeatNode->loop = loopKind(advance().type);
+            repeatNode->addChild(assignNode);
             repeatNode->addChild(parseExpression());
             expect(TokenType::TOK_SEMICOLON, ";");
             return repeatNode;
@@ -346,12 +476,12 @@ ASTNodePtr Parser::parseExpressionOrAssign() {
 
     // Check for repeat with plain expression body: expr ('while'|'until') expr ';'
     if (check(TokenType::TOK_WHILE) || check(TokenType::TOK_UNTIL)) {
-        const Token& kw = advance();
-        auto repeatNode = makeNode(ASTNode::STMT_REPEAT, loc, kw.text);
+        auto repeatNode = makeNode(ASTNode::STMT_REPEAT, loc);
+        repeatNode->loop = loopKind(advance().type);
 
         auto bodyStmt = makeNode(ASTNode::STMT_EXPR, expr->loc);
-        bodyStmt->addChild(std::move(expr));
-        repeatNode->addChild(std::move(bodyStmt));
+        bodyStmt->addChild(expr);
+        repeatNode->addChild(bodyStmt);
 
         repeatNode->addChild(parseExpression());
         expect(TokenType::TOK_SEMICOLON, ";");
@@ -360,153 +490,108 @@ ASTNodePtr Parser::parseExpressionOrAssign() {
 
     expect(TokenType::TOK_SEMICOLON, ";");
     auto stmtNode = makeNode(ASTNode::STMT_EXPR, loc);
-    stmtNode->addChild(std::move(expr));
+    stmtNode->addChild(expr);
     return stmtNode;
 }
 
 ASTNodePtr Parser::parseExpression() {
-    return parseExprOr();
-}
-
-ASTNodePtr Parser::parseExprOr() {
-    auto left = parseExprAnd();
-    while (check(TokenType::TOK_OR)) {
-        auto loc = current().loc;
-        auto op = advance();
-        auto right = parseExprAnd();
-        auto node = makeNode(ASTNode::EXPR_BINARY, loc, op.text);
-        node->addChild(std::move(left));
-        node->addChild(std::move(right));
-        left = std::move(node);
-    }
-    return left;
-}
-
-ASTNodePtr Parser::parseExprAnd() {
-    auto left = parseExprComparison();
-    while (check(TokenType::TOK_AND)) {
-        auto loc = current().loc;
-        auto op = advance();
-        auto right = parseExprComparison();
-        auto node = makeNode(ASTNode::EXPR_BINARY, loc, op.text);
-        node->addChild(std::move(left));
-        node->addChild(std::move(right));
-        left = std::move(node);
-    }
-    return left;
-}
-
-ASTNodePtr Parser::parseExprComparison() {
-    auto left = parseExprBitOr();
-    while (check(TokenType::TOK_LT) || check(TokenType::TOK_GT) ||
-           check(TokenType::TOK_LE) || check(TokenType::TOK_GE) ||
-           check(TokenType::TOK_EQ) || check(TokenType::TOK_NE)) {
-        auto loc = current().loc;
-        auto op = advance();
-        auto right = parseExprBitOr();
-        auto node = makeNode(ASTNode::EXPR_BINARY, loc, op.text);
-        node->addChild(std::move(left));
-        node->addChild(std::move(right));
-        left = std::move(node);
-    }
-    return left;
-}
-
-ASTNodePtr Parser::parseExprBitOr() {
-    auto left = parseExprBitXor();
-    while (check(TokenType::TOK_PIPE)) {
-        auto loc = current().loc;
-        auto op = advance();
-        auto right = parseExprBitXor();
-        auto node = makeNode(ASTNode::EXPR_BINARY, loc, op.text);
-        node->addChild(std::move(left));
-        node->addChild(std::move(right));
-        left = std::move(node);
-    }
-    return left;
-}
-
-ASTNodePtr Parser::parseExprBitXor() {
-    auto left = parseExprBitAnd();
-    while (check(TokenType::TOK_CARET)) {
-        auto loc = current().loc;
-        auto op = advance();
-        auto right = parseExprBitAnd();
-        auto node = makeNode(ASTNode::EXPR_BINARY, loc, op.text);
-        node->addChild(std::move(left));
-        node->addChild(std::move(right));
-        left = std::move(node);
-    }
-    return left;
-}
-
-ASTNodePtr Parser::parseExprBitAnd() {
-    auto left = parseExprShift();
-    while (check(TokenType::TOK_AMP)) {
-        auto loc = current().loc;
-        auto op = advance();
-        auto right = parseExprShift();
-        auto node = makeNode(ASTNode::EXPR_BINARY, loc, op.text);
-        node->addChild(std::move(left));
-        node->addChild(std::move(right));
-        left = std::move(node);
-    }
-    return left;
-}
-
-ASTNodePtr Parser::parseExprShift() {
-    auto left = parseExprAdd();
-    while (check(TokenType::TOK_SHL) || check(TokenType::TOK_SHR)) {
-        auto loc = current().loc;
-        auto op = advance();
-        auto right = parseExprAdd();
-        auto node = makeNode(ASTNode::EXPR_BINARY, loc, op.text);
-        node->addChild(std::move(left));
-        node->addChild(std::move(right));
-        left = std::move(node);
-    }
-    return left;
-}
-
-ASTNodePtr Parser::parseExprAdd() {
-    auto left = parseExprMul();
-    while (check(TokenType::TOK_PLUS) || check(TokenType::TOK_MINUS)) {
-        auto loc = current().loc;
-        auto op = advance();
-        auto right = parseExprMul();
-        auto node = makeNode(ASTNode::EXPR_BINARY, loc, op.text);
-        node->addChild(std::move(left));
-        node->addChild(std::move(right));
-        left = std::move(node);
-    }
-    return left;
-}
-
-ASTNodePtr Parser::parseExprMul() {
+    DepthGuard guard(*this);
+    if (guard.tooDeep()) return makeNode(ASTNode::EXPR_LITERAL, current().loc, "<error>");
+    return parseExprBinary(1);
+}
+
+namespace {
+
+// Left binding power and operation of each binary operator; power 0
+// means the token does not continue a binary expression. Higher binds
+// tighter.
+constexpr size_t TOKEN_TYPE_COUNT = static_cast<size_t>(TokenType::TOK_ERROR) + 1;
+
+struct BinaryOperatorTable {
+    uint8_t power[TOKEN_TYPE_COUNT];
+    Operator op[TOKEN_TYPE_COUNT];
+};
+
+constexpr BinaryOperatorTable buildBinaryOperators() {
+    BinaryOperatorTable t{};
+    auto set = [&t](TokenType type, uint8_t power, Operator op) {
+        t.power[static_cast<size_t>(type)] = power;
+        t.op[static_cast<size_t>(type)] = op;
+    };
+    set(TokenType::TOK_OR, 1, Operator::OR);
+    set(TokenType::TOK_AND, 2, Operator::AND);
+    set(TokenType::TOK_LT, 3, Operator::LT);
+    set(TokenType::TOK_GT, 3, Operator::GT);
+    set(TokenType::TOK_LE, 3, Operator::LE);
+    set(TokenType::TOK_GE, 3, Operator::GE);
+    set(TokenType::TOK_EQ, 3, Operator::EQ);
+    set(TokenType::TOK_NE, 3, Operator::NE);
+    set(TokenType::TOK_PIPE, 4, Operator::BIT_OR);
+    set(TokenType::TOK_CARET, 5, Operator::BIT_XOR);
+    set(TokenType::TOK_AMP, 6, Operator::BIT_AND);
+    set(TokenType::TOK_SHL, 7, Operator::SHL);
+    set(TokenType::TOK_SHR, 7, Operator::SHR);
+    set(TokenType::TOK_PLUS, 8, Operator::ADD);
+    set(TokenType::TOK_MINUS, 8, Operator::SUB);
+    set(TokenType::TOK_STAR, 9, Operator::MUL);
+    set(TokenType::TOK_SLASH, 9, Operator::DIV);
+    set(TokenType::TOK_PERCENT, 9, Operator::MOD);
+    return t;
+}
+
+constexpr BinaryOperatorTable BINARY_OPERATORS = buildBinaryOperators();
+
+uint8_t bindingPower(TokenType type) {
+    return BINARY_OPERATORS.power[static_cast<size_t>(type)];
+}
+
+Operator binaryOperator(TokenType type) {
+    return BINARY_OPERATORS.op[static_cast<size_t>(type)];
+}
+
+} // namespace
+
+// Precedence climbing: parses operators binding at least minPower. All
+// binary operators are left-associative, so the right operand only takes
+// operators that bind strictly tighter.
+ASTNodePtr Parser::parseExprBinary(int minPower) {
     auto left = parseExprUnary();
-    while (check(TokenType::TOK_STAR) || check(TokenType::TOK_SLASH) || check(TokenType::TOK_PERCENT)) {
+    for (;;) {
+        int power = bindingPower(current().type);
+        if (power == 0 || power < minPower) break;
         auto loc = current().loc;
-        auto op = advance();
-        auto right = parseExprUnary();
-        auto node = makeNode(ASTNode::EXPR_BINARY, loc, op.text);
-        node->addChild(std::move(left));
-        node->addChild(std::move(right));
-        left = std::move(node);
+        Operator op = binaryOperator(advance().type);
+        auto right = parseExprBinary(power + 1);
+        auto node = makeNode(ASTNode::EXPR_BINARY, loc);
+        node->op = op;
+        node->addChild(left);
+        node->addChild(right);
+        left = node;
     }
     return left;
 }
 
+// Prefix operators are chained in a loop, so "- - - x" does not recurse.
 ASTNodePtr Parser::parseExprUnary() {
-    if (check(TokenType::TOK_MINUS) || check(TokenType::TOK_TILDE) ||
-        check(TokenType::TOK_BANG) || check(TokenType::TOK_INC) || check(TokenType::TOK_DEC_OP)) {
+    ASTNodePtr outer = nullptr;
+    ASTNodePtr inner = nullptr;
+    while (check(TokenType::TOK_MINUS) || check(TokenType::TOK_TILDE) ||
+           check(TokenType::TOK_BANG) || check(TokenType::TOK_INC) || check(TokenType::TOK_DEC_OP)) {
         auto loc = current().loc;
-        auto op = advance();
-        auto operand = parseExprUnary();
-        auto node = makeNode(ASTNode::EXPR_UNARY, loc, op.text);
-        node->addChild(std::move(operand));
-        return node;
+        auto node = makeNode(ASTNode::EXPR_UNARY, loc);
+        node->op = prefixOperator(advance().type);
+        if (inner) {
+            inner->addChild(node);
+        } else {
+            outer = node;
+        }
+        inner = node;
     }
-    return parseExprPostfix();
+
+    auto operand = parseExprPostfix();
+    if (!inner) return operand;
+    inner->addChild(operand);
+    return outer;
 }
 
 ASTNodePtr Parser::parseExprPostfix() {
@@ -518,7 +603,7 @@ ASTNodePtr Parser::parseExprPostfix() {
             auto loc = current().loc;
             advance(); // '('
             auto callNode = makeNode(ASTNode::EXPR_CALL, loc);
-            callNode->addChild(std::move(expr));
+            callNode->addChild(expr);
             if (!check(TokenType::TOK_RPAREN)) {
                 callNode->addChild(parseExpression());
                 while (match(TokenType::TOK_COMMA)) {
@@ -526,13 +611,13 @@ ASTNodePtr Parser::parseExprPostfix() {
                 }
             }
             expect(TokenType::TOK_RPAREN, ")");
-            expr = std::move(callNode);
+            expr = callNode;
         } else if (check(TokenType::TOK_LBRACKET)) {
             // Slice/index: expr '[' list<range> ']'
             auto loc = current().loc;
             advance(); // '['
             auto sliceNode = makeNode(ASTNode::EXPR_SLICE, loc);
-            sliceNode->addChild(std::move(expr));
+            sliceNode->addChild(expr);
 
             // Parse range: expr ('..' expr)?
             auto parseRange = [this]() -> ASTNodePtr {
@@ -540,8 +625,8 @@ ASTNodePtr Parser::parseExprPostfix() {
                 if (match(TokenType::TOK_DOTDOT)) {
                     auto to = parseExpression();
                     auto rangeNode = makeNode(ASTNode::EXPR_RANGE, from->loc);
-                    rangeNode->addChild(std::move(from));
-                    rangeNode->addChild(std::move(to));
+                    rangeNode->addChild(from);
+                    rangeNode->addChild(to);
                     return rangeNode;
                 }
                 return from;
@@ -552,14 +637,15 @@ ASTNodePtr Parser::parseExprPostfix() {
                 sliceNode->addChild(parseRange());
             }
             expect(TokenType::TOK_RBRACKET, "]");
-            expr = std::move(sliceNode);
+            expr = sliceNode;
         } else if (check(TokenType::TOK_INC) || check(TokenType::TOK_DEC_OP)) {
             // Postfix ++ or --
             auto loc = current().loc;
-            auto op = advance();
-            auto node = makeNode(ASTNode::EXPR_UNARY, loc, "post" + op.text);
-            node->addChild(std::move(expr));
-            expr = std::move(node);
+            bool inc = advance().type == TokenType::TOK_INC;
+            auto node = makeNode(ASTNode::EXPR_UNARY, loc);
+            node->op = inc ? Operator::POST_INC : Operator::POST_DEC;
+            node->addChild(expr);
+            expr = node;
         } else {
             break;
         }
@@ -574,7 +660,7 @@ ASTNodePtr Parser::parseExprPrimary() {
         auto inner = parseExpression();
         expect(TokenType::TOK_RPAREN, ")");
         auto node = makeNode(ASTNode::EXPR_BRACES, loc);
-        node->addChild(std::move(inner));
+        node->addChild(inner);
         return node;
     }
 
@@ -582,15 +668,209 @@ ASTNodePtr Parser::parseExprPrimary() {
         check(TokenType::TOK_STRING) || check(TokenType::TOK_CHAR) ||
         check(TokenType::TOK_TRUE) || check(TokenType::TOK_FALSE)) {
         auto tok = advance();
-        return makeNode(ASTNode::EXPR_LITERAL, loc, tok.text);
+        auto node = makeNode(ASTNode::EXPR_LITERAL, loc, tok.text);
+        node->literal = tok.literal;
+        return node;
     }
 
     if (check(TokenType::TOK_IDENT)) {
-        auto tok = advance();
-        return makeNode(ASTNode::EXPR_PLACE, loc, tok.text);
+        auto node = makeNode(ASTNode::EXPR_PLACE, loc);
+        setName(*node, advance());
+        return node;
     }
 
-    error("expected expression, got '" + current().text + "'");
+    error("expected expression, got '" + std::string(current().text) + "'");
     advance();
     return makeNode(ASTNode::EXPR_LITERAL, loc, "<error>");
 }
+
+// --- Outline mode -------------------------------------------------------------
+
+namespace {
+
+// Where skipFuncBody() is inside a statement.
+enum class SkipState {
+    STATEMENT,          // at the start of one
+    EXPRESSION,         // expression statement, if condition
+    LOOP_CONDITION,     // expression after 'while'/'until'
+    SIGNATURE,          // argument list of a nested 'def'
+    AFTER_SIGNATURE,    // 'of' or the nested body
+    RETURN_TYPE,        // type name after 'of'
+    ARRAY_SUFFIX,       // 'array' '[' dec ']' after it
+};
+
+bool isOperandToken(TokenType type) {
+    switch (type) {
+        case TokenType::TOK_IDENT:
+        case TokenType::TOK_DEC:
+        case TokenType::TOK_HEX:
+        case TokenType::TOK_BITS:
+        case TokenType::TOK_STRING:
+        case TokenType::TOK_CHAR:
+        case TokenType::TOK_TRUE:
+        case TokenType::TOK_FALSE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool isPrefixOperator(TokenType type) {
+    return type == TokenType::TOK_MINUS || type == TokenType::TOK_TILDE ||
+           type == TokenType::TOK_BANG || type == TokenType::TOK_INC ||
+           type == TokenType::TOK_DEC_OP;
+}
+
+// Follows a loop condition token by token the way parseExpression()
+// would. Returns false for the first token that is not part of it.
+struct ConditionScanner {
+    size_t brackets = 0;
+    bool expectOperand = true;
+
+    bool accept(TokenType type) {
+        if (brackets > 0) {
+            if (type == TokenType::TOK_LPAREN || type == TokenType::TOK_LBRACKET) {
+                brackets++;
+            } else if (type == TokenType::TOK_RPAREN || type == TokenType::TOK_RBRACKET) {
+                if (--brackets == 0) expectOperand = false;
+            }
+            return true;
+        }
+        if (expectOperand) {
+            if (isOperandToken(type)) {
+                expectOperand = false;
+                return true;
+            }
+            if (type == TokenType::TOK_LPAREN) {
+                brackets = 1;
+                return true;
+            }
+            return isPrefixOperator(type);
+        }
+        if (bindingPower(type) > 0) {
+            expectOperand = true;
+            return true;
+        }
+        // Call, slice, postfix ++/--.
+        if (type == TokenType::TOK_LPAREN || type == TokenType::TOK_LBRACKET) {
+            brackets = 1;
+            return true;
+        }
+        return type == TokenType::TOK_INC || type == TokenType::TOK_DEC_OP;
+    }
+};
+
+} // namespace
+
+// Steps over a function body without building it, stopping where
+// parseFuncBody() would: after the matching 'end', or before a 'def' or
+// TOK_EOF at body level. 'begin'/'{', nested 'def' and 'while'/'until'
+// loops open a level closed by 'end'/'}'. A 'while'/'until' after an
+// expression statement is a repeat suffix instead, so statement starts
+// are tracked, including the one right after a loop condition. Input
+// without syntax errors ends up with the same function boundaries as a
+// full parse.
+void Parser::skipFuncBody(ASTNodePtr func) {
+    size_t firstToken = head_;
+    uint64_t begin = current().loc.offset;
+    size_t depth = 0;
+    size_t parens = 0;
+    ConditionScanner condition;
+    SkipState state = SkipState::STATEMENT;
+    bool done = false;
+
+    while (!done && !isAtEnd()) {
+        TokenType type = current().type;
+
+        // States that end at a token belonging to what follows fall
+        // through to the statement rules below.
+        switch (state) {
+            case SkipState::SIGNATURE:
+                if (type == TokenType::TOK_LPAREN) {
+                    parens++;
+                } else if (type == TokenType::TOK_RPAREN && parens > 0 && --parens == 0) {
+                    state = SkipState::AFTER_SIGNATURE;
+                }
+                advance();
+                continue;
+            case SkipState::AFTER_SIGNATURE:
+                if (type == TokenType::TOK_OF) {
+                    state = SkipState::RETURN_TYPE;
+                    advance();
+                    continue;
+                }
+                state = SkipState::STATEMENT;
+                break;
+            case SkipState::RETURN_TYPE:
+                state = SkipState::ARRAY_SUFFIX;
+                advance();
+                continue;
+            case SkipState::ARRAY_SUFFIX:
+                if (type == TokenType::TOK_ARRAY || type == TokenType::TOK_LBRACKET ||
+                    type == TokenType::TOK_DEC || type == TokenType::TOK_RBRACKET) {
+                    advance();
+                    continue;
+                }
+                state = SkipState::STATEMENT;
+                break;
+            case SkipState::LOOP_CONDITION:
+                if (condition.accept(type)) {
+                    advance();
+                    continue;
+                }
+                state = SkipState::STATEMENT;
+                break;
+            default:
+                break;
+        }
+
+        switch (type) {
+            case TokenType::TOK_DEF:
+                if (depth == 0) {
+                    done = true;
+                    continue;
+                }
+                depth++;
+                parens = 0;
+                state = SkipState::SIGNATURE;
+                break;
+            case TokenType::TOK_BEGIN:
+            case TokenType::TOK_LBRACE:
+                depth++;
+                state = SkipState::STATEMENT;
+                break;
+            case TokenType::TOK_END:
+                if (depth == 0) {
+                    done = true;
+                } else {
+                    depth--;
+                }
+                state = SkipState::STATEMENT;
+                break;
+            case TokenType::TOK_RBRACE:
+                if (depth > 0) depth--;
+                state = SkipState::STATEMENT;
+                break;
+            case TokenType::TOK_WHILE:
+            case TokenType::TOK_UNTIL:
+                if (state == SkipState::STATEMENT) {
+                    depth++;
+                    condition = ConditionScanner();
+                    state = SkipState::LOOP_CONDITION;
+                }
+                break;
+            case TokenType::TOK_SEMICOLON:
+            case TokenType::TOK_THEN:
+            case TokenType::TOK_ELSE:
+                state = SkipState::STATEMENT;
+                break;
+            default:
+                state = SkipState::EXPRESSION;
+                break;
+        }
+        advance();
+    }
+
+    uint64_t end = head_ > firstToken ? consumedEnd() : begin;
+    bodies_.push_back({func, firstToken, head_ - firstToken, begin, end});
+}
@@ -0,0 +1,107 @@
+#include "../include/source_buffer.h"
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const size_t READ_BLOCK_SIZE = 64 * 1024;
+
+SourceBuffer::SourceBuffer(std::string text)
+    : owned_(std::move(text)) {
+    data_ = owned_.data();
+    size_ = owned_.size();
+}
+
+SourceBuffer::SourceBuffer(SourceBuffer&& other) noexcept {
+    *this = std::move(other);
+}
+
+SourceBuffer& SourceBuffer::operator=(SourceBuffer&& other) noexcept {
+    if (this == &other) return *this;
+    release();
+    mapped_ = other.mapped_;
+    size_ = other.size_;
+    if (mapped_) {
+        data_ = other.data_;
+    } else {
+        // The string may use the small-buffer optimization, so the data
+        // pointer has to be taken again after the move.
+        owned_ = std::move(other.owned_);
+        data_ = owned_.data();
+    }
+    other.data_ = "";
+    other.size_ = 0;
+    other.mapped_ = false;
+    return *this;
+}
+
+SourceBuffer::~SourceBuffer() {
+    release();
+}
+
+void SourceBuffer::release() {
+#if !defined(_WIN32)
+    if (mapped_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+    owned_.clear();
+    data_ = "";
+    size_ = 0;
+    mapped_ = false;
+}
+
+SourceBuffer SourceBuffer::fromStream(std::istream& in) {
+    std::string content;
+    std::string block(READ_BLOCK_SIZE, '\0');
+    while (in.read(&block[0], static_cast<std::streamsize>(block.size())) || in.gcount() > 0) {
+        content.append(block.data(), static_cast<size_t>(in.gcount()));
+    }
+    return SourceBuffer(std::move(content));
+}
+
+SourceBuffer SourceBuffer::fromFile(const std::string& path) {
+#if !defined(_WIN32)
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open input file: " + path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) &&
+        static_cast<size_t>(st.st_size) >= MAP_THRESHOLD) {
+        size_t size = static_cast<size_t>(st.st_size);
+        void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            close(fd);
+            madvise(addr, size, MADV_SEQUENTIAL);
+            SourceBuffer buffer;
+            buffer.data_ = static_cast<const char*>(addr);
+            buffer.size_ = size;
+            buffer.mapped_ = true;
+            return buffer;
+        }
+    }
+    close(fd);
+#endif
+
+    std::ifstream in(path, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!in.is_open()) {
+        throw std::runtime_error("Cannot open input file: " + path);
+    }
+    std::streamoff size = in.tellg();
+    if (size < 0) {
+        in.clear();
+        return fromStream(in);
+    }
+    std::string content(static_cast<size_t>(size), '\0');
+    in.seekg(0);
+    in.read(&content[0], size);
+    content.resize(static_cast<size_t>(in.gcount()));
+    return SourceBuffer(std::move(content));
+}
@@ -0,0 +1,66 @@
+#include "../include/symbol_table.h"
+
+static const size_t INITIAL_SLOTS = 1024;
+
+// FNV-1a; identifiers are short, so a simple byte loop is enough.
+static uint32_t hashName(std::string_view name) {
+    uint32_t h = 2166136261u;
+    for (char c : name) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+SymbolTable::SymbolTable() : slots_(INITIAL_SLOTS, 0) {}
+
+SymbolId SymbolTable::lookup(std::string_view name, uint32_t hash) const {
+    size_t mask = slots_.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        uint32_t slot = slots_[i];
+        if (slot == 0) return NO_SYMBOL;
+        SymbolId id = slot - 1;
+        if (hashes_[id] == hash && names_[id] == name) return id;
+    }
+}
+
+SymbolId SymbolTable::find(std::string_view name) const {
+    return lookup(name, hashName(name));
+}
+
+SymbolId SymbolTable::intern(std::string_view name) {
+    uint32_t hash = hashName(name);
+    SymbolId found = lookup(name, hash);
+    if (found != NO_SYMBOL) return found;
+
+    size_t mask = slots_.size() - 1;
+    SymbolId id = static_cast<SymbolId>(names_.size());
+    names_.push_back(name);
+    hashes_.push_back(hash);
+    // Keep the load factor at or below one half.
+    if (names_.size() * 2 > slots_.size()) {
+        grow();
+    } else {
+        for (size_t i = hash & mask;; i = (i + 1) & mask) {
+            if (slots_[i] == 0) {
+                slots_[i] = id + 1;
+                break;
+            }
+        }
+    }
+    return id;
+}
+
+void SymbolTable::grow() {
+    std::vector<uint32_t> slots(slots_.size() * 2, 0);
+    size_t mask = slots.size() - 1;
+    for (SymbolId id = 0; id < names_.size(); ++id) {
+        for (size_t i = hashes_[id] & mask;; i = (i + 1) & mask) {
+            if (slots[i] == 0) {
+                slots[i] = id + 1;
+                break;
+            }
+        }
+    }
+    slots_.swap(slots);
+}
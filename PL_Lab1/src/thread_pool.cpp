@@ -0,0 +1,77 @@
+#include "../include/thread_pool.h"
+#include <cerrno>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <process.h>
+#include <windows.h>
+#endif
+
+ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0) threads = 1;
+    workers_.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        NativeThread thread;
+#if defined(_WIN32)
+        thread = _beginthreadex(nullptr, static_cast<unsigned>(STACK_SIZE), workerMain, this,
+                                STACK_SIZE_PARAM_IS_A_RESERVATION, nullptr);
+        int err = thread == 0 ? errno : 0;
+#else
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        int err = pthread_attr_setstacksize(&attr, STACK_SIZE);
+        if (err == 0) err = pthread_create(&thread, &attr, workerMain, this);
+        pthread_attr_destroy(&attr);
+#endif
+        if (err != 0) {
+            stop();
+            throw std::system_error(err, std::generic_category(), "Cannot start a worker thread");
+        }
+        workers_.push_back(thread);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    stop();
+}
+
+#if defined(_WIN32)
+unsigned __stdcall ThreadPool::workerMain(void* pool) {
+#else
+void* ThreadPool::workerMain(void* pool) {
+#endif
+    static_cast<ThreadPool*>(pool)->run();
+    return 0;
+}
+
+void ThreadPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    ready_.notify_all();
+    for (NativeThread worker : workers_) {
+#if defined(_WIN32)
+        HANDLE handle = reinterpret_cast<HANDLE>(worker);
+        WaitForSingleObject(handle, INFINITE);
+        CloseHandle(handle);
+#else
+        pthread_join(worker, nullptr);
+#endif
+    }
+    workers_.clear();
+}
+
+void ThreadPool::run() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ready_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) return;
+            task = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        task();
+    }
+}
@@ -0,0 +1,66 @@
+#include "../include/token_pipe.h"
+
+static_assert((TokenPipe::RING_BATCHES & (TokenPipe::RING_BATCHES - 1)) == 0,
+              "RING_BATCHES must be a power of two");
+
+TokenPipe::TokenPipe(TokenSource& producer)
+    : producer_(producer), ring_(std::make_unique<Batch[]>(RING_BATCHES)) {
+    thread_ = std::thread([this]() { produce(); });
+}
+
+TokenPipe::~TokenPipe() {
+    stopping_.store(true, std::memory_order_relaxed);
+    if (thread_.joinable()) thread_.join();
+}
+
+void TokenPipe::produce() {
+    size_t written = 0;
+    bool eof = false;
+    while (!eof) {
+        // Wait for the consumer to hand a slot back. Yielding rather than
+        // spinning keeps this cheap when both threads share a core.
+        while (written - read_.load(std::memory_order_acquire) == RING_BATCHES &&
+               !stopping_.load(std::memory_order_relaxed)) {
+            std::this_thread::yield();
+        }
+        if (stopping_.load(std::memory_order_relaxed)) break;
+
+        Batch& batch = ring_[written % RING_BATCHES];
+        batch.size = 0;
+        while (batch.size < BATCH_TOKENS && !eof) {
+            Token& tok = batch.tokens[batch.size++];
+            tok = producer_.next();
+            eof = tok.type == TokenType::TOK_EOF;
+        }
+        // Publishes the batch's tokens (and the lexer state they point
+        // into, e.g. unescaped strings) to the consumer.
+        written_.store(++written, std::memory_order_release);
+    }
+
+    // The consumer left early: finish the stream anyway, so the
+    // producer's errors do not depend on how far it had got.
+    while (!eof) eof = producer_.next().type == TokenType::TOK_EOF;
+}
+
+Token TokenPipe::next() {
+    if (atEof_) return eof_;
+    if (!current_ || pos_ == current_->size) {
+        size_t read = read_.load(std::memory_order_relaxed);
+        if (current_) read_.store(++read, std::memory_order_release);
+        while (written_.load(std::memory_order_acquire) == read) {
+            std::this_thread::yield();
+        }
+        current_ = &ring_[read % RING_BATCHES];
+        pos_ = 0;
+    }
+
+    const Token& tok = current_->tokens[pos_++];
+    if (tok.type == TokenType::TOK_EOF) {
+        atEof_ = true;
+        eof_ = tok;
+        // The producer is done; joining here makes its state safe to read
+        // as soon as the consumer has seen the end of the stream.
+        thread_.join();
+    }
+    return tok;
+}
@@ -0,0 +1,137 @@
+// Round trip of the binary AST format, and rejection of corrupt node tables.
+//
+// Usage: binary_ast_test <source-file> <tree.ast> <output.dot>
+// Loads <tree.ast> (written by --format=bin from <source-file>), checks the
+// stored positions against the source, rebuilds the tree with toTree() and
+// writes it as DOT, to be compared with a direct DOT export. Then damages
+// copies of the node table and expects validate() to reject each of them.
+
+#include "../include/binary_ast.h"
+#include "../include/dot_export.h"
+
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Corruption {
+    const char* name;
+    std::function<void(BinaryNode* nodes, uint32_t count)> apply;
+};
+
+// Index of the first node with a child that has a child of its own, so
+// that the grandchild's parent ends before the array does.
+uint32_t firstGrandparent(const BinaryNode* nodes, uint32_t count) {
+    for (uint32_t i = 0; i + 2 < count; ++i) {
+        if (nodes[i].childCount > 0 && nodes[i + 1].childCount > 0) return i;
+    }
+    throw std::runtime_error("The test tree is too shallow");
+}
+
+const std::vector<Corruption> CORRUPTIONS = {
+    {"root does not span the array", [](BinaryNode* nodes, uint32_t count) {
+        nodes[0].end = count - 1;
+    }},
+    {"end before the node", [](BinaryNode* nodes, uint32_t) {
+        nodes[1].end = 1;
+    }},
+    {"end past the array", [](BinaryNode* nodes, uint32_t count) {
+        nodes[count - 1].end = count + 1;
+    }},
+    {"child overruns its parent", [](BinaryNode* nodes, uint32_t count) {
+        uint32_t i = firstGrandparent(nodes, count);
+        nodes[i + 2].end = nodes[i + 1].end + 1;
+    }},
+    {"child count too high", [](BinaryNode* nodes, uint32_t) {
+        nodes[0].childCount += 1;
+    }},
+    {"child count too low", [](BinaryNode* nodes, uint32_t count) {
+        nodes[firstGrandparent(nodes, count)].childCount -= 1;
+    }},
+    {"unknown kind", [](BinaryNode* nodes, uint32_t count) {
+        nodes[count / 2].kind = 200;
+    }},
+    {"unknown operator", [](BinaryNode* nodes, uint32_t count) {
+        for (uint32_t i = 0; i < count; ++i) {
+            if (nodes[i].kind == ASTNode::EXPR_BINARY) {
+                nodes[i].tag = 200;
+                return;
+            }
+        }
+        throw std::runtime_error("The test tree has no binary expression");
+    }},
+};
+
+std::string readFile(const std::string& path) {
+    SourceBuffer buffer = SourceBuffer::fromFile(path);
+    return std::string(buffer.view());
+}
+
+// Stored line/column must be what the source gives for the offset.
+void checkPositions(const BinaryAst& ast, const LineIndex& lines) {
+    for (uint32_t i = 0; i < ast.size(); ++i) {
+        LineColumn stored = ast.position(i);
+        LineColumn expected = lines.resolve(ast.loc(i).offset);
+        if (stored.line != expected.line || stored.column != expected.column) {
+            throw std::runtime_error("Node " + std::to_string(i) + " has a wrong position");
+        }
+    }
+}
+
+// Returns the number of corruptions validate() accepted.
+int checkCorruptions(const std::string& file) {
+    int failures = 0;
+    for (const Corruption& corruption : CORRUPTIONS) {
+        std::string copy = file;
+        BinaryAstHeader header;
+        std::memcpy(&header, copy.data(), sizeof(header));
+        auto* nodes = reinterpret_cast<BinaryNode*>(&copy[header.nodesOffset]);
+        corruption.apply(nodes, static_cast<uint32_t>(header.nodeCount));
+
+        BinaryAst ast{SourceBuffer(std::move(copy))};
+        try {
+            ast.validate();
+            std::cerr << "Not rejected: " << corruption.name << "\n";
+            ++failures;
+        } catch (const std::runtime_error&) {
+        }
+    }
+    return failures;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc != 4) {
+        std::cerr << "Usage: " << argv[0] << " <source-file> <tree.ast> <output.dot>\n";
+        return 2;
+    }
+
+    try {
+        SourceBuffer source = SourceBuffer::fromFile(argv[1]);
+        LineIndex lines(source.view());
+
+        BinaryAst ast = BinaryAst::fromFile(argv[2]);
+        checkPositions(ast, lines);
+        AstArena arena;
+        SymbolTable symbols;
+        ASTNodePtr tree = ast.toTree(arena, symbols);
+        const std::string outputPath = argv[3];
+        OutputBuffer out(outputPath);
+        DotExporter::exportTree(tree, lines, symbols, out);
+        out.flush();
+
+        if (checkCorruptions(readFile(argv[2])) != 0) return 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    std::cout << "Binary AST round trip done, " << CORRUPTIONS.size()
+              << " corrupt node tables rejected\n";
+    return 0;
+}
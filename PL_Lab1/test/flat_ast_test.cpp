@@ -0,0 +1,109 @@
+// Checks the flat AST layout against the pointer tree it was made from.
+//
+// Usage: flat_ast_test <source-file>...
+// For each file, FlatAst::fromTree() of the parsed tree, the tree rebuilt
+// from it with toTree(), and Parser::parseFlat() must all export the same
+// DOT and JSON (pretty and compact) as the pointer tree does.
+
+#include "../include/parser.h"
+#include "../include/dot_export.h"
+#include "../include/json_export.h"
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string readFile(const char* path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error(std::string("Cannot open ") + path);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+struct Exports {
+    std::string dot;
+    std::string json;
+    std::string compact;
+
+    bool operator==(const Exports& other) const {
+        return dot == other.dot && json == other.json && compact == other.compact;
+    }
+};
+
+// Works for both an ASTNode* and a FlatAst.
+template <typename Tree>
+Exports exportAll(const Tree& tree, const Lexer& lexer) {
+    return {DotExporter::exportTree(tree, lexer.lines(), lexer.symbols()),
+            JsonExporter::exportTree(tree, lexer.lines(), lexer.symbols(), JsonStyle::PRETTY),
+            JsonExporter::exportTree(tree, lexer.lines(), lexer.symbols(), JsonStyle::COMPACT)};
+}
+
+size_t countNodes(const ASTNode* root) {
+    size_t count = 0;
+    std::vector<const ASTNode*> pending{root};
+    while (!pending.empty()) {
+        const ASTNode* node = pending.back();
+        pending.pop_back();
+        ++count;
+        for (const ASTNode* child : node->children) pending.push_back(child);
+    }
+    return count;
+}
+
+bool check(const char* path) {
+    std::string text = readFile(path);
+    Lexer lexer(text);
+    Parser parser(lexer);
+    ParseResult result = parser.parse();
+    Exports expected = exportAll(result.tree, lexer);
+
+    FlatAst flat = FlatAst::fromTree(result.tree);
+    if (flat.size() != countNodes(result.tree) || flat.end(0) != flat.size()) {
+        std::cerr << path << ": the flat layout does not hold every node once\n";
+        return false;
+    }
+    if (!(exportAll(flat, lexer) == expected)) {
+        std::cerr << path << ": the flat exporters differ from the tree exporters\n";
+        return false;
+    }
+
+    AstArena arena;
+    if (!(exportAll(flat.toTree(arena), lexer) == expected)) {
+        std::cerr << path << ": the tree rebuilt by toTree() exports differently\n";
+        return false;
+    }
+
+    Lexer flatLexer(text);
+    Parser flatParser(flatLexer);
+    FlatParseResult flatResult = flatParser.parseFlat();
+    if (!(exportAll(flatResult.ast, flatLexer) == expected) ||
+        flatResult.errors.size() != result.errors.size()) {
+        std::cerr << path << ": parseFlat() differs from parse()\n";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <source-file>...\n";
+        return 2;
+    }
+    try {
+        for (int i = 1; i < argc; ++i) {
+            if (!check(argv[i])) return 1;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    std::cout << argc - 1 << " files: flat layout exports as the pointer tree\n";
+    return 0;
+}
@@ -0,0 +1,132 @@
+// Randomized check that IncrementalParser::update() gives the same tree and
+// diagnostics as a full Lexer + Parser run over the edited text.
+//
+// Usage: incremental_test <steps> <source-file>...
+// Each file gets <steps> rounds of one to three random edits. The seed is
+// fixed, so a failure reproduces; the text that failed is printed.
+
+#include "../include/incremental_parser.h"
+#include "../include/dot_export.h"
+#include "../include/json_export.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <cstdlib>
+
+namespace {
+
+constexpr unsigned SEED = 20240601;
+
+// Inserted text: tokens, fragments that change how the rest of the file
+// lexes (comment and string openers) or nests, and whole functions.
+const char* const SNIPPETS[] = {
+    "def", "end", " f()", " ", "\n", "\t", "x = 1;", ";", "x", "y1", "+", "<<", "--",
+    "/*", "*/", "//", "\"", "'", "\\", "@", "(", ")", "{", "}", "0x",
+    "begin", "if a then ", "while x ", "break;", "a[1..2]", "\"a\\n\"", "'c'",
+    "123456789012345678901234", "((((((((((((((((((((((((((((((((((((",
+    "def g(a of int array[3]) of bool\n  return(a);\nend\n", "end\ndef h()\n",
+};
+
+std::string readFile(const char* path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error(std::string("Cannot open ") + path);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+// Everything the two parses must agree on, as one string.
+std::string describe(const ASTNode* tree, const LineIndex& lines, const SymbolTable& symbols,
+                     const std::vector<ParseError>& errors,
+                     const std::vector<LexerError>& lexerErrors, bool aborted) {
+    std::string out = JsonExporter::exportTree(tree, lines, symbols);
+    out += DotExporter::exportTree(tree, lines, symbols);
+    for (const auto& e : errors) {
+        out += "parse " + std::to_string(e.loc.offset) + ": " + e.message + "\n";
+    }
+    for (const auto& e : lexerErrors) {
+        out += "lexer " + std::to_string(e.loc.offset) + ": " + e.message + "\n";
+    }
+    out += aborted ? "aborted\n" : "completed\n";
+    return out;
+}
+
+std::string fullParse(const std::string& text, const ParserOptions& options) {
+    Lexer lexer(text);
+    Parser parser(lexer, options);
+    ParseResult result = parser.parse();
+    return describe(result.tree, lexer.lines(), lexer.symbols(), result.errors,
+                    lexer.errors(), parser.aborted());
+}
+
+std::string incrementalParse(IncrementalParser& parser) {
+    return describe(parser.tree(), parser.lines(), parser.symbols(), parser.errors(),
+                    parser.lexerErrors(), parser.aborted());
+}
+
+TextEdit randomEdit(std::mt19937& rng, const std::string& text) {
+    TextEdit edit;
+    edit.offset = rng() % (text.size() + 1);
+    uint64_t available = text.size() - edit.offset;
+    switch (rng() % 4) {
+    case 0: edit.length = 0; break;
+    case 3: edit.length = std::min<uint64_t>(available, rng() % 200); break;
+    default: edit.length = std::min<uint64_t>(available, rng() % 8); break;
+    }
+    if (rng() % 4 != 0) {
+        edit.text = SNIPPETS[rng() % std::size(SNIPPETS)];
+    } else if (!text.empty()) {
+        // Text copied from elsewhere in the file.
+        edit.text = text.substr(rng() % text.size(), rng() % 100);
+    }
+    return edit;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <steps> <source-file>...\n";
+        return 2;
+    }
+    int steps = std::atoi(argv[1]);
+    std::mt19937 rng(SEED);
+    size_t checks = 0;
+
+    try {
+        for (int i = 2; i < argc; ++i) {
+            std::string text = readFile(argv[i]);
+            ParserOptions options;
+            // A low limit makes edits cross the nesting limit in both directions.
+            if (rng() % 2 == 0) options.maxDepth = 20;
+            IncrementalParser parser(text, options);
+
+            for (int step = 0; step < steps; ++step) {
+                std::vector<TextEdit> edits(1 + rng() % 3);
+                for (auto& edit : edits) {
+                    edit = randomEdit(rng, text);
+                    text.replace(edit.offset, edit.length, edit.text);
+                }
+                parser.update(edits);
+                ++checks;
+                if (parser.source() != text || incrementalParse(parser) != fullParse(text, options)) {
+                    std::cerr << argv[i] << ": step " << step << " (seed " << SEED
+                              << ", maxDepth " << options.maxDepth
+                              << "): incremental result differs from a full parse of:\n"
+                              << text << "\n";
+                    return 1;
+                }
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    std::cout << checks << " edits checked against a full parse\n";
+    return 0;
+}
@@ -0,0 +1,116 @@
+// Checks keyword recognition against the unordered_map the lexer used
+// before keywordType() became a length/first-character switch.
+//
+// Usage: keyword_test
+// Lexes, as one source, every keyword, every prefix of each, each one
+// extended by a character on either side, each with every position
+// replaced, upper- and mixed-case spellings, and every [a-z] word of up to
+// four letters, and compares each token's type with the old table.
+
+#include "../include/lexer.h"
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+const std::unordered_map<std::string_view, TokenType> KEYWORDS = {
+    {"def",    TokenType::TOK_DEF},
+    {"end",    TokenType::TOK_END},
+    {"if",     TokenType::TOK_IF},
+    {"then",   TokenType::TOK_THEN},
+    {"else",   TokenType::TOK_ELSE},
+    {"while",  TokenType::TOK_WHILE},
+    {"until",  TokenType::TOK_UNTIL},
+    {"break",  TokenType::TOK_BREAK},
+    {"begin",  TokenType::TOK_BEGIN},
+    {"of",     TokenType::TOK_OF},
+    {"bool",   TokenType::TOK_BOOL},
+    {"byte",   TokenType::TOK_BYTE},
+    {"int",    TokenType::TOK_INT},
+    {"uint",   TokenType::TOK_UINT},
+    {"long",   TokenType::TOK_LONG},
+    {"ulong",  TokenType::TOK_ULONG},
+    {"char",   TokenType::TOK_CHARTYPE},
+    {"string", TokenType::TOK_STRINGTYPE},
+    {"array",  TokenType::TOK_ARRAY},
+    {"true",   TokenType::TOK_TRUE},
+    {"false",  TokenType::TOK_FALSE},
+};
+
+TokenType expectedType(std::string_view word) {
+    auto it = KEYWORDS.find(word);
+    return it == KEYWORDS.end() ? TokenType::TOK_IDENT : it->second;
+}
+
+const std::string IDENT_START = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_";
+const std::string IDENT_CHARS = IDENT_START + "0123456789";
+
+std::vector<std::string> testWords() {
+    std::vector<std::string> words;
+    for (const auto& entry : KEYWORDS) {
+        const std::string keyword(entry.first);
+        words.push_back(keyword);
+        for (size_t length = 1; length < keyword.size(); ++length) {
+            words.push_back(keyword.substr(0, length));
+        }
+        for (char c : IDENT_CHARS) words.push_back(keyword + c);
+        for (char c : IDENT_START) words.push_back(c + keyword);
+        for (size_t i = 0; i < keyword.size(); ++i) {
+            for (char c : i == 0 ? IDENT_START : IDENT_CHARS) {
+                std::string changed = keyword;
+                changed[i] = c;
+                words.push_back(changed);
+            }
+        }
+        std::string upper = keyword;
+        for (char& c : upper) c = static_cast<char>(c - 'a' + 'A');
+        words.push_back(upper);
+        words.push_back(upper.substr(0, 1) + keyword.substr(1));
+    }
+    std::string word;
+    for (size_t length = 1; length <= 4; ++length) {
+        word.assign(length, 'a');
+        for (;;) {
+            words.push_back(word);
+            size_t i = length;
+            while (i > 0 && word[i - 1] == 'z') word[--i] = 'a';
+            if (i == 0) break;
+            ++word[i - 1];
+        }
+    }
+    return words;
+}
+
+} // namespace
+
+int main() {
+    std::vector<std::string> words = testWords();
+    std::string source;
+    for (const std::string& word : words) source += word + "\n";
+
+    Lexer lexer(source);
+    size_t mismatches = 0;
+    for (const std::string& word : words) {
+        Token token = lexer.next();
+        if (token.text != word) {
+            std::cerr << "Expected one token for '" << word << "', got '" << token.text << "'\n";
+            return 1;
+        }
+        if (token.type != expectedType(word)) {
+            std::cerr << "Wrong token type for '" << word << "'\n";
+            ++mismatches;
+        }
+    }
+    if (lexer.next().type != TokenType::TOK_EOF || !lexer.errors().empty()) {
+        std::cerr << "Unexpected trailing tokens or lexer errors\n";
+        return 1;
+    }
+    if (mismatches != 0) return 1;
+
+    std::cout << words.size() << " words classified as by the old keyword table\n";
+    return 0;
+}
@@ -0,0 +1,131 @@
+// Checks the literal values the lexer decodes, and its diagnostics for
+// literals it cannot decode.
+//
+// Usage: literal_test
+// Lexes each case on its own and compares the token type, the decoded
+// value and the lexer errors with the expected ones.
+
+#include "../include/lexer.h"
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct Case {
+    std::string source;
+    TokenType type;
+    LiteralKind kind;
+    uint64_t integer;       // LIT_INT, LIT_BOOL, LIT_CHAR
+    std::string string;     // LIT_STRING
+    std::string error;      // expected lexer error, empty for none
+};
+
+Case intCase(std::string source, TokenType type, uint64_t value, std::string error = "") {
+    return {std::move(source), type, LiteralKind::LIT_INT, value, "", std::move(error)};
+}
+
+Case charCase(std::string source, uint64_t code) {
+    return {std::move(source), TokenType::TOK_CHAR, LiteralKind::LIT_CHAR, code, "", ""};
+}
+
+Case stringCase(std::string source, std::string value) {
+    return {std::move(source), TokenType::TOK_STRING, LiteralKind::LIT_STRING, 0, std::move(value),
+            ""};
+}
+
+Case errorCase(std::string source, std::string error) {
+    return {std::move(source), TokenType::TOK_ERROR, LiteralKind::LIT_NONE, 0, "",
+            std::move(error)};
+}
+
+const std::vector<Case> CASES = {
+    intCase("0", TokenType::TOK_DEC, 0),
+    intCase("42", TokenType::TOK_DEC, 42),
+    intCase("007", TokenType::TOK_DEC, 7),
+    intCase("18446744073709551615", TokenType::TOK_DEC, UINT64_MAX),
+    intCase("18446744073709551616", TokenType::TOK_DEC, 0,
+            "Integer literal out of range: 18446744073709551616"),
+    intCase("123456789012345678901234", TokenType::TOK_DEC, 0,
+            "Integer literal out of range: 123456789012345678901234"),
+
+    intCase("0xFF", TokenType::TOK_HEX, 255),
+    intCase("0XfF", TokenType::TOK_HEX, 255),
+    intCase("0xDeadBeef", TokenType::TOK_HEX, 0xdeadbeef),
+    intCase("0x0000000000000000000000001", TokenType::TOK_HEX, 1),
+    intCase("0xffffffffffffffff", TokenType::TOK_HEX, UINT64_MAX),
+    intCase("0x10000000000000000", TokenType::TOK_HEX, 0,
+            "Integer literal out of range: 0x10000000000000000"),
+    intCase("0x", TokenType::TOK_HEX, 0),
+
+    intCase("0b10110", TokenType::TOK_BITS, 22),
+    intCase("0B1", TokenType::TOK_BITS, 1),
+    intCase("0b" + std::string(64, '1'), TokenType::TOK_BITS, UINT64_MAX),
+    intCase("0b1" + std::string(64, '0'), TokenType::TOK_BITS, 0,
+            "Integer literal out of range: 0b1" + std::string(64, '0')),
+
+    {"true", TokenType::TOK_TRUE, LiteralKind::LIT_BOOL, 1, "", ""},
+    {"false", TokenType::TOK_FALSE, LiteralKind::LIT_BOOL, 0, "", ""},
+
+    charCase("'A'", 'A'),
+    charCase("' '", ' '),
+    charCase("'\\'", '\\'),
+    charCase("'\"'", '"'),
+    charCase("'\xff'", 0xff),
+    charCase("''", 0),
+    errorCase("'", "Unterminated char literal"),
+    errorCase("'a", "Unterminated char literal"),
+
+    stringCase("\"\"", ""),
+    stringCase("\"hello world\"", "hello world"),
+    stringCase("\"a\\nb\"", "a\nb"),
+    stringCase("\"\\t\\r\\n\"", "\t\r\n"),
+    stringCase("\"nul\\0\"", std::string("nul\0", 4)),
+    stringCase("\"\\\"quoted\\\"\"", "\"quoted\""),
+    stringCase("\"back\\\\slash\"", "back\\slash"),
+    stringCase("\"\\q\\'\"", "q'"),
+    stringCase("\"multi\nline\"", "multi\nline"),
+    errorCase("\"open", "Unterminated string literal"),
+    errorCase("\"escaped quote\\\"", "Unterminated string literal"),
+};
+
+bool check(const Case& c) {
+    Lexer lexer(c.source);
+    Token token = lexer.next();
+    const LiteralValue& literal = token.literal;
+    std::string problem;
+    if (token.type != c.type) {
+        problem = "wrong token type";
+    } else if (literal.kind != c.kind) {
+        problem = "wrong literal kind";
+    } else if (c.kind == LiteralKind::LIT_STRING ? literal.string() != c.string
+                                                  : c.kind != LiteralKind::LIT_NONE &&
+                                                        literal.integer != c.integer) {
+        problem = "wrong value";
+    } else if (lexer.next().type != TokenType::TOK_EOF) {
+        problem = "more than one token";
+    } else if (c.error.empty() ? !lexer.errors().empty()
+                               : lexer.errors().size() != 1 ||
+                                     lexer.errors()[0].message != c.error ||
+                                     lexer.errors()[0].loc.offset != 0) {
+        problem = c.error.empty() ? "unexpected error" : "expected error '" + c.error + "'";
+    }
+    if (!problem.empty()) std::cerr << c.source << ": " << problem << "\n";
+    return problem.empty();
+}
+
+} // namespace
+
+int main() {
+    size_t failures = 0;
+    for (const Case& c : CASES) {
+        if (!check(c)) ++failures;
+    }
+    if (failures != 0) return 1;
+
+    std::cout << CASES.size() << " literals decoded as expected\n";
+    return 0;
+}
@@ -0,0 +1,154 @@
+// Checks that an outline parse with every skipped body parsed afterwards
+// with Parser::parseBody() gives the tree and diagnostics of a full parse.
+//
+// Usage: outline_test <source-file>...
+// Each file is parsed twice in outline mode. Bodies are filled in from
+// the token vector the first time, and from the outline parse's own Lexer,
+// restart()ed at each body, the second time; lexer errors already
+// reported must not come back. The files are expected to parse without
+// errors. A built-in source with lexer errors inside bodies is checked too.
+
+#include "../include/parser.h"
+#include "../include/dot_export.h"
+#include "../include/json_export.h"
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Errors inside bodies only, so the two parses report them in one order.
+const char* const LEXER_ERRORS_SOURCE =
+    "def f(a of int) of int\n"
+    "    x = 1 @ 2;\n"
+    "    s = \"a\\q\" # 'b';\n"
+    "end\n"
+    "def g()\n"
+    "    while x ` 1 end\n"
+    "end\n";
+
+std::string readFile(const char* path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error(std::string("Cannot open ") + path);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+// Everything the two parses must agree on, as one string.
+std::string describe(const ASTNode* tree, const Lexer& lexer,
+                     const std::vector<ParseError>& errors) {
+    std::string out = JsonExporter::exportTree(tree, lexer.lines(), lexer.symbols());
+    out += DotExporter::exportTree(tree, lexer.lines(), lexer.symbols());
+    for (const auto& e : errors) {
+        out += "parse " + std::to_string(e.loc.offset) + ": " + e.message + "\n";
+    }
+    for (const auto& e : lexer.errors()) {
+        out += "lexer " + std::to_string(e.loc.offset) + ": " + e.message + "\n";
+    }
+    return out;
+}
+
+std::string fullParse(const std::string& text, std::vector<ParseError>& errors) {
+    Lexer lexer(text);
+    Parser parser(lexer);
+    ParseResult result = parser.parse();
+    errors = result.errors;
+    return describe(result.tree, lexer, result.errors);
+}
+
+ParserOptions outlineOptions() {
+    ParserOptions options;
+    options.outline = true;
+    return options;
+}
+
+// Parses body with parser into result, checking that it ends where the
+// outline parse said it does. Returns the diagnostics.
+std::vector<ParseError> parseBody(Parser& parser, const BodyRange& body, ParseResult& result) {
+    parser.parseBody(body, *result.arena);
+    if (parser.consumed() != body.tokenCount) {
+        throw std::runtime_error("Body at offset " + std::to_string(body.begin) + " took " +
+                                 std::to_string(parser.consumed()) + " tokens, the outline " +
+                                 std::to_string(body.tokenCount));
+    }
+    return parser.errors();
+}
+
+// The outline parse's diagnostics followed by those of each body, in
+// source order, as the full parse reports them for the sources checked.
+std::vector<ParseError> allErrors(const ParseResult& result,
+                                  const std::vector<std::vector<ParseError>>& bodyErrors) {
+    std::vector<ParseError> errors = result.errors;
+    for (const auto& body : bodyErrors) errors.insert(errors.end(), body.begin(), body.end());
+    return errors;
+}
+
+std::string fromTokenVector(const std::string& text) {
+    Lexer lexer(text);
+    std::vector<Token> tokens = lexer.tokenize();
+    Parser outline(tokens, outlineOptions());
+    ParseResult result = outline.parse();
+    std::vector<std::vector<ParseError>> bodyErrors;
+    for (const BodyRange& body : result.bodies) {
+        TokenVectorSource source(tokens, body.firstToken);
+        Parser parser(source);
+        bodyErrors.push_back(parseBody(parser, body, result));
+    }
+    return describe(result.tree, lexer, allErrors(result, bodyErrors));
+}
+
+std::string fromRestartedLexer(const std::string& text) {
+    Lexer lexer(text);
+    Parser outline(lexer, outlineOptions());
+    ParseResult result = outline.parse();
+    // Last body first, so that restart() has to go back each time.
+    std::vector<std::vector<ParseError>> bodyErrors(result.bodies.size());
+    for (size_t i = result.bodies.size(); i-- > 0;) {
+        lexer.restart(result.bodies[i].begin);
+        Parser parser(lexer);
+        bodyErrors[i] = parseBody(parser, result.bodies[i], result);
+    }
+    return describe(result.tree, lexer, allErrors(result, bodyErrors));
+}
+
+bool check(const std::string& name, const std::string& text, bool errorFree) {
+    std::vector<ParseError> errors;
+    std::string expected = fullParse(text, errors);
+    if (errorFree && !errors.empty()) {
+        std::cerr << name << ": expected to parse without errors\n";
+        return false;
+    }
+    if (fromTokenVector(text) != expected) {
+        std::cerr << name << ": bodies parsed from the token vector differ from a full parse\n";
+        return false;
+    }
+    if (fromRestartedLexer(text) != expected) {
+        std::cerr << name << ": bodies parsed after Lexer::restart() differ from a full parse\n";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <source-file>...\n";
+        return 2;
+    }
+    try {
+        for (int i = 1; i < argc; ++i) {
+            if (!check(argv[i], readFile(argv[i]), true)) return 1;
+        }
+        if (!check("built-in source with lexer errors", LEXER_ERRORS_SOURCE, false)) return 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    std::cout << argc << " sources: outline parse plus bodies matches a full parse\n";
+    return 0;
+}
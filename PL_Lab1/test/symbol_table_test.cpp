@@ -0,0 +1,173 @@
+// Checks identifier interning: SymbolTable itself, and the ids the Lexer
+// and IncrementalParser hand out.
+//
+// Usage: symbol_table_test
+// Interns names that share a probe chain, two names with the same 32-bit
+// hash, and enough names to grow the table many times, then checks every
+// id and name. Checks that Lexer::restart() gives identifiers their old
+// ids and that IncrementalParser keeps ids across edits.
+
+#include "../include/incremental_parser.h"
+#include "../include/symbol_table.h"
+
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// Initial slot count of SymbolTable (symbol_table.cpp).
+constexpr uint32_t INITIAL_SLOTS = 1024;
+
+// Same hash as SymbolTable's, to pick names that collide.
+uint32_t fnv1a(std::string_view name) {
+    uint32_t h = 2166136261u;
+    for (char c : name) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+void require(bool condition, const std::string& what) {
+    if (!condition) throw std::runtime_error(what);
+}
+
+// Interns names in order and checks the ids, first as they are handed
+// out and then after all of them are in.
+void internAll(SymbolTable& table, const std::vector<std::string>& names) {
+    SymbolId first = static_cast<SymbolId>(table.size());
+    for (size_t i = 0; i < names.size(); ++i) {
+        require(table.find(names[i]) == NO_SYMBOL, "'" + names[i] + "' found before interning");
+        require(table.intern(names[i]) == first + i, "'" + names[i] + "' got a sparse id");
+        require(table.intern(names[i]) == first + i, "'" + names[i] + "' interned twice");
+    }
+    for (size_t i = 0; i < names.size(); ++i) {
+        require(table.find(names[i]) == first + i, "'" + names[i] + "' lost its id");
+        require(table.name(first + i) == names[i], "id of '" + names[i] + "' names another");
+    }
+}
+
+void checkCollisions() {
+    // Names that all start probing at slot 0, so each one has to step
+    // over the others.
+    std::vector<std::string> chain;
+    for (uint32_t i = 0; chain.size() < 40; ++i) {
+        std::string name = "p" + std::to_string(i);
+        if ((fnv1a(name) & (INITIAL_SLOTS - 1)) == 0) chain.push_back(name);
+    }
+    // Two names with the same full hash, told apart by their bytes.
+    std::unordered_map<uint32_t, std::string> seen;
+    std::vector<std::string> twins;
+    for (uint32_t i = 0; twins.empty(); ++i) {
+        std::string name = "h" + std::to_string(i);
+        auto [it, inserted] = seen.emplace(fnv1a(name), name);
+        if (!inserted) twins = {it->second, name};
+    }
+
+    SymbolTable table;
+    internAll(table, chain);
+    internAll(table, twins);
+    internAll(table, {"", "_", "a"});
+    require(table.size() == chain.size() + 5, "wrong size after collisions");
+}
+
+void checkGrowth() {
+    // 200000 names grow the table from INITIAL_SLOTS past 2^18 slots.
+    std::vector<std::string> names;
+    for (uint32_t i = 0; i < 200000; ++i) names.push_back("n" + std::to_string(i * 7919u));
+    SymbolTable table;
+    internAll(table, names);
+    require(table.size() == names.size(), "wrong size after growth");
+}
+
+// Identifier tokens of the lexer's source, in order.
+std::vector<Token> identifiers(Lexer& lexer) {
+    std::vector<Token> found;
+    for (Token tok = lexer.next(); tok.type != TokenType::TOK_EOF; tok = lexer.next()) {
+        if (tok.type == TokenType::TOK_IDENT) found.push_back(tok);
+    }
+    return found;
+}
+
+void checkRestart() {
+    const std::string source = "def f(a of T) x = a + b; y = x; end def g() f(b); end";
+    Lexer lexer(source);
+    std::vector<Token> first = identifiers(lexer);
+    size_t symbols = lexer.symbols().size();
+    require(symbols == 7, "expected 7 distinct identifiers");
+    for (const Token& tok : first) {
+        require(lexer.symbols().name(tok.symbol) == tok.text, "'" + std::string(tok.text) +
+                                                                  "' has another name's id");
+    }
+    // Again from the second token, and from a later one.
+    for (size_t skip : {size_t(1), first.size() / 2}) {
+        lexer.restart(first[skip].loc.offset);
+        std::vector<Token> again = identifiers(lexer);
+        require(again.size() == first.size() - skip, "restart() lexed other tokens");
+        for (size_t i = 0; i < again.size(); ++i) {
+            require(again[i].symbol == first[skip + i].symbol,
+                    "'" + std::string(again[i].text) + "' got a new id after restart()");
+        }
+        require(lexer.symbols().size() == symbols, "restart() interned names again");
+    }
+}
+
+// Ids of the identifier nodes under root by name, checking that each
+// node's id names the identifier at its location in source.
+std::unordered_map<std::string, SymbolId> nodeSymbols(const ASTNode* root, std::string_view source,
+                                                      const SymbolTable& symbols) {
+    std::unordered_map<std::string, SymbolId> found;
+    std::vector<const ASTNode*> pending{root};
+    while (!pending.empty()) {
+        const ASTNode* node = pending.back();
+        pending.pop_back();
+        for (const ASTNode* child : node->children) pending.push_back(child);
+        if (node->symbol == NO_SYMBOL) continue;
+        require(node->symbol < symbols.size(), "node id past the symbol table");
+        std::string name(symbols.name(node->symbol));
+        require(source.substr(node->loc.offset, name.size()) == name,
+                "node at " + std::to_string(node->loc.offset) + " has the id of '" + name + "'");
+        found.emplace(name, node->symbol);
+    }
+    return found;
+}
+
+void checkIncremental() {
+    std::string source = "def f(a of T) x = a + b; end\ndef g() y = f(c); end\n";
+    IncrementalParser doc(source);
+    auto before = nodeSymbols(doc.tree(), doc.source(), doc.symbols());
+    require(before.size() == 8, "expected 8 named identifiers");
+
+    // A new function in front brings new names and old ones in a new
+    // order; an edit inside g() reparses it with a fresh Lexer.
+    doc.update({{0, 0, "def h(c of U) z = c + q; end\n"}});
+    size_t g = doc.source().find("y = f(c)");
+    doc.update({{g, 1, "w"}});
+    auto after = nodeSymbols(doc.tree(), doc.source(), doc.symbols());
+    for (const auto& [name, id] : before) {
+        require(!after.count(name) || after[name] == id, "'" + name + "' changed its id");
+    }
+    require(after.count("q") && after["q"] >= before.size(), "'q' did not get a new id");
+    require(after.count("w") && after["w"] >= before.size(), "'w' did not get a new id");
+}
+
+} // namespace
+
+int main() {
+    try {
+        checkCollisions();
+        checkGrowth();
+        checkRestart();
+        checkIncremental();
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    std::cout << "Symbol ids are dense, stable and name their identifiers\n";
+    return 0;
+}